@@ -0,0 +1,353 @@
+// Throughput benchmark over seeded scenes. Every run is reproducible from
+// its seed; results go to stdout (and optionally a file) as CSV, one row per
+// scene/size/thread-count, so runs can be diffed between releases.
+//
+//   benchmark [--scenes collision,collision_gpu,nbody,nbody_direct,nbody_gpu,viscosity,columns]
+//             [--sizes 1000,4000] [--threads 1,2,4,8] [--steps N] [--warmup N] [--repeat N]
+//             [--simd native,scalar] [--seed N] [--out results.csv]
+//
+// nbody_gpu is the nbody scene with exact forces from the compute shader
+// (gpuForces.h), and nbody_direct the same exact sum on the CPU threads, so
+// the two compare like for like where nbody's tree does not. collision_gpu
+// steps the collision scene on the GPU (gpuCollision.h), without CCD or
+// sleeping; its checksum varies a little between runs. The GPU scenes are
+// skipped, with a note, where GL 4.3 is missing.
+#include <SFML/System.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "kollision.h"
+#include "nbody.h"
+#include "gpuCollision.h"
+#include "gpuForces.h"
+#include "viscosity.h"
+#include "jobSystem.h"
+#include "simdKernels.h"
+
+namespace {
+    struct Options {
+        std::vector<std::string> scenes{ "collision", "collision_gpu", "nbody", "nbody_direct", "nbody_gpu",
+            "viscosity", "columns" };
+        std::vector<int> sizes;    // empty = per-scene defaults
+        std::vector<int> threads{ 1 };
+        std::vector<std::string> simd{ "native" }; // kernel levels to compare
+        int steps = 200;
+        int warmup = 20;
+        int repeat = 3;
+        unsigned seed = 1;
+        std::string outFile;
+    };
+
+    struct Result {
+        double bestUs = 0.0;     // fastest repeat
+        std::size_t bodies = 0;
+        std::size_t bytes = 0;   // heap held by the world after the run
+        double checksum = 0.0;   // sum of final positions, to catch behaviour changes
+    };
+
+    constexpr float DT = 1.f / 240.f;
+
+    template <class T>
+    std::vector<T> splitList(const std::string& value) {
+        std::vector<T> out;
+        std::stringstream ss(value);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            if (item.empty()) continue;
+            if constexpr (std::is_same_v<T, std::string>) out.push_back(item);
+            else out.push_back(static_cast<T>(std::stoi(item)));
+        }
+        return out;
+    }
+
+    std::vector<int> defaultSizes(const std::string& scene) {
+        if (scene == "collision" || scene == "collision_gpu") return { 1000, 4000, 16000, 64000 };
+        if (scene == "nbody" || scene == "nbody_gpu") return { 1000, 10000, 50000 };
+        // O(n^2) on the CPU; the sizes nbody_gpu shares that finish in minutes
+        if (scene == "nbody_direct") return { 1000, 10000 };
+        if (scene == "columns") return { 1000, 5000, 20000 };
+        return { 100, 1000, 10000 };
+    }
+
+    double positionChecksum(const ParticleStore& p) {
+        double sum = 0.0;
+        for (std::size_t i = 0; i < p.size(); ++i) sum += double(p.x[i]) + p.y[i];
+        return sum;
+    }
+
+    // Times opts.repeat runs of opts.steps steps on fresh copies of one scene,
+    // after opts.warmup untimed steps each.
+    template <class MakeWorld>
+    Result measure(const Options& opts, MakeWorld makeWorld) {
+        Result result;
+        for (int r = 0; r < opts.repeat; ++r) {
+            auto world = makeWorld();
+            for (int s = 0; s < opts.warmup; ++s) world->step(DT);
+            sf::Clock clock;
+            for (int s = 0; s < opts.steps; ++s) world->step(DT);
+            world->finish();
+            const double us = static_cast<double>(clock.getElapsedTime().asMicroseconds());
+            if (r == 0 || us < result.bestUs) result.bestUs = us;
+            result.bodies = world->bodyCount();
+            result.bytes = world->memoryBytes();
+            result.checksum = world->checksum();
+        }
+        return result;
+    }
+
+    // Thin wrappers so every scene exposes step/finish/memoryBytes/bodyCount/checksum.
+    // finish() waits for steps still queued on the GPU; the CPU scenes have none.
+    struct CollisionScene {
+        CollisionWorld world;
+        void step(float dt) { world.step(dt); }
+        void finish() {}
+        std::size_t memoryBytes() const { return world.memoryBytes(); }
+        std::size_t bodyCount() const { return world.balls.size(); }
+        double checksum() const { return positionChecksum(world.balls); }
+    };
+    // The world is shared by every run, so the shaders build once; the
+    // balls on the host are only the starting state and the final readback
+    struct GpuCollisionScene {
+        GpuCollisionWorld* gpu = nullptr;
+        ParticleStore balls;
+        void step(float dt) { gpu->step(dt); }
+        void finish() { gpu->counters(); }
+        std::size_t memoryBytes() const { return balls.memoryBytes(); }
+        std::size_t bodyCount() const { return balls.size(); }
+        double checksum() {
+            gpu->download(balls);
+            return positionChecksum(balls);
+        }
+    };
+    struct NBodyScene {
+        NBodyWorld world;
+        void step(float dt) { world.step(dt); }
+        void finish() {}
+        std::size_t memoryBytes() const { return world.memoryBytes(); }
+        std::size_t bodyCount() const { return world.bodies.size(); }
+        double checksum() const { return positionChecksum(world.bodies); }
+    };
+    struct ViscosityScene {
+        ViscosityWorld world;
+        void step(float dt) { world.step(dt); }
+        void finish() {}
+        std::size_t memoryBytes() const { return world.memoryBytes(); }
+        std::size_t bodyCount() const { return world.balls.size(); }
+        double checksum() const { return positionChecksum(world.balls); }
+    };
+
+    struct ColumnsScene {
+        ViscosityColumns world;
+        void step(float dt) { world.step(dt); }
+        void finish() {}
+        std::size_t memoryBytes() const { return world.memoryBytes(); }
+        std::size_t bodyCount() const { return world.bodyCount(); }
+        double checksum() const {
+            double sum = 0.0;
+            for (const CollisionWorld& c : world.columns) sum += positionChecksum(c.balls);
+            return sum;
+        }
+    };
+
+    // Square box at ~30% area fraction, so density stays fixed as n grows
+    CollisionWorld makeCollisionWorld(int n, unsigned seed) {
+        const float radius = 4.f;
+        const float side = std::sqrt(n * 3.14159265f * radius * radius / 0.3f);
+        CollisionWorld world;
+        world.bounds = sf::FloatRect(0.f, 0.f, side, side);
+        std::mt19937 rng{ seed };
+        world.spawn(n, radius, radius, rng);
+        std::uniform_real_distribution<float> uv(-200.f, 200.f);
+        for (int i = 0; i < n; ++i) {
+            world.balls.vx[i] = uv(rng);
+            world.balls.vy[i] = uv(rng);
+        }
+        return world;
+    }
+
+    struct GpuContexts {
+        std::unique_ptr<GpuNBodyForces> forces;
+        std::unique_ptr<GpuCollisionWorld> collision;
+    };
+
+    Result runScene(const Options& opts, const std::string& scene, int n, JobSystem* pool, GpuContexts& gpu) {
+        if (scene == "collision") {
+            return measure(opts, [&] {
+                auto s = std::make_unique<CollisionScene>();
+                s->world = makeCollisionWorld(n, opts.seed);
+                s->world.pool = pool;
+                return s;
+            });
+        }
+        if (scene == "collision_gpu") {
+            return measure(opts, [&] {
+                const CollisionWorld world = makeCollisionWorld(n, opts.seed);
+                auto s = std::make_unique<GpuCollisionScene>();
+                s->gpu = gpu.collision.get();
+                s->gpu->bounds = world.bounds;
+                s->gpu->config = world.config;
+                s->balls = world.balls;
+                s->gpu->upload(s->balls);
+                return s;
+            });
+        }
+        if (scene == "nbody" || scene == "nbody_direct" || scene == "nbody_gpu") {
+            return measure(opts, [&] {
+                auto s = std::make_unique<NBodyScene>();
+                s->world = makeSolarNBody(n, opts.seed);
+                s->world.pool = pool;
+                s->world.directSum = scene == "nbody_direct";
+                if (scene == "nbody_gpu") s->world.gpu = gpu.forces.get();
+                return s;
+            });
+        }
+        if (scene == "columns") {
+            return measure(opts, [&] {
+                // n balls of r = 2 split over the default fluids; columns grow
+                // taller with n so the area fraction stays at ~25%
+                const auto& fluids = defaultFluids();
+                const int perColumn = std::max(1, n / (int)fluids.size());
+                const float radius = 2.f, width = 150.f;
+                const float height = std::max(50.f, perColumn * 3.14159265f * radius * radius / (0.25f * width));
+                std::vector<sf::FloatRect> rects;
+                for (std::size_t c = 0; c < fluids.size(); ++c)
+                    rects.emplace_back(c * (width + 100.f), 0.f, width, height);
+                auto s = std::make_unique<ColumnsScene>();
+                s->world.pool = pool;
+                s->world.build(fluids, rects, perColumn, radius, opts.seed);
+                return s;
+            });
+        }
+        return measure(opts, [&] {
+            // n columns of the default fluids, balls dropped from random heights
+            const auto& fluids = defaultFluids();
+            auto s = std::make_unique<ViscosityScene>();
+            std::mt19937 rng{ opts.seed };
+            std::uniform_real_distribution<float> drop(100.f, 450.f);
+            for (int i = 0; i < n; ++i)
+                s->world.addBall(i * 40.f + 20.f, drop(rng), 10.f, fluids[i % fluids.size()].viscosity, 500.f);
+            return s;
+        });
+    }
+
+    bool parseArgs(int argc, char** argv, Options& opts) {
+        try {
+            for (int i = 1; i < argc; ++i) {
+                std::string arg = argv[i];
+                if (i + 1 >= argc) throw std::invalid_argument(arg);
+                std::string value = argv[++i];
+                if (arg == "--scenes") opts.scenes = splitList<std::string>(value);
+                else if (arg == "--sizes") opts.sizes = splitList<int>(value);
+                else if (arg == "--threads") opts.threads = splitList<int>(value);
+                else if (arg == "--simd") opts.simd = splitList<std::string>(value);
+                else if (arg == "--steps") opts.steps = std::stoi(value);
+                else if (arg == "--warmup") opts.warmup = std::stoi(value);
+                else if (arg == "--repeat") opts.repeat = std::stoi(value);
+                else if (arg == "--seed") opts.seed = static_cast<unsigned>(std::stoul(value));
+                else if (arg == "--out") opts.outFile = value;
+                else throw std::invalid_argument(arg);
+            }
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Bad argument: " << e.what() << "\n";
+            return false;
+        }
+        for (const auto& scene : opts.scenes) {
+            if (scene != "collision" && scene != "collision_gpu" && scene != "nbody" && scene != "nbody_direct"
+                && scene != "nbody_gpu" && scene != "viscosity" && scene != "columns") {
+                std::cerr << "Unknown scene: " << scene << "\n";
+                return false;
+            }
+        }
+        for (const auto& level : opts.simd) {
+            if (level != "native" && level != "scalar" && level != "neon" && level != "avx2") {
+                std::cerr << "Unknown SIMD level: " << level << "\n";
+                return false;
+            }
+        }
+        return opts.steps > 0 && opts.repeat > 0 && opts.warmup >= 0
+            && !opts.threads.empty() && !opts.simd.empty();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        std::cerr << "usage: benchmark [--scenes collision,collision_gpu,nbody,nbody_direct,nbody_gpu,viscosity,columns]\n"
+            "       [--sizes N,...] [--threads T,...] [--simd native,scalar,...] [--steps N] [--warmup N] [--repeat N] [--seed N] [--out file.csv]\n";
+        return 1;
+    }
+
+    std::ofstream file;
+    if (!opts.outFile.empty()) {
+        file.open(opts.outFile);
+        if (!file) {
+            std::cerr << "Failed to open " << opts.outFile << "\n";
+            return 1;
+        }
+    }
+    auto emit = [&](const std::string& line) {
+        std::cout << line << std::endl;
+        if (file) file << line << '\n';
+    };
+
+    // One GPU context per GPU scene for all its runs, so the shaders build once
+    auto wanted = [&](const char* scene) {
+        return std::find(opts.scenes.begin(), opts.scenes.end(), scene) != opts.scenes.end();
+    };
+    GpuContexts gpu;
+    if (wanted("nbody_gpu")) {
+        gpu.forces = std::make_unique<GpuNBodyForces>();
+        if (!gpu.forces->ready()) std::cerr << "Skipping nbody_gpu: " << gpu.forces->error() << "\n";
+    }
+    if (wanted("collision_gpu")) {
+        gpu.collision = std::make_unique<GpuCollisionWorld>();
+        if (!gpu.collision->ready()) std::cerr << "Skipping collision_gpu: " << gpu.collision->error() << "\n";
+    }
+
+    emit("scene,bodies,threads,simd,steps,seed,wall_ms,steps_per_sec,ns_per_body_step,bytes_per_body,checksum");
+    for (const auto& level : opts.simd) {
+        if (level == "native") setSimdLevel(detectSimdLevel());
+        else if (level == "avx2") setSimdLevel(SimdLevel::Avx2);
+        else if (level == "neon") setSimdLevel(SimdLevel::Neon);
+        else setSimdLevel(SimdLevel::Scalar);
+        for (const auto& scene : opts.scenes) {
+            if (scene == "nbody_gpu" && !gpu.forces->ready()) continue;
+            if (scene == "collision_gpu" && !gpu.collision->ready()) continue;
+            const std::vector<int> sizes = opts.sizes.empty() ? defaultSizes(scene) : opts.sizes;
+            for (int n : sizes) {
+                for (int t : opts.threads) {
+                    // The viscosity solver is sequential and the GPU scenes
+                    // leave the threads idle; only run them once per size
+                    const bool sequential = scene == "viscosity" || scene == "nbody_gpu" || scene == "collision_gpu";
+                    if (sequential && t != opts.threads.front()) continue;
+                    const int threads = sequential ? 1 : std::max(t, 1);
+                    // A pool even for one thread, so every row of a scaling
+                    // curve runs the same (graph-coloured) solver
+                    JobSystem pool(threads);
+
+                    const Result r = runScene(opts, scene, n, &pool, gpu);
+                    const double us = std::max(r.bestUs, 1.0);
+                    const double bodies = static_cast<double>(std::max<std::size_t>(r.bodies, 1));
+                    std::ostringstream row;
+                    row << scene << ',' << r.bodies << ',' << threads << ',' << simdKernels().name
+                        << ',' << opts.steps << ',' << opts.seed
+                        << ',' << us / 1000.0
+                        << ',' << opts.steps * 1e6 / us
+                        << ',' << us * 1000.0 / (opts.steps * bodies)
+                        << ',' << r.bytes / bodies
+                        << ',' << r.checksum;
+                    emit(row.str());
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "assets.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+AssetCache::AssetCache() {
+    // Started here rather than in the initializer list so every member the
+    // loader reads is constructed first
+    loader = std::thread([this] { loaderLoop(); });
+}
+
+AssetCache::~AssetCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    loader.join();
+}
+
+AssetCache::Entry& AssetCache::find(const std::string& path, bool isFont) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(path);
+    if (it != entries.end()) return *it->second;
+    auto entry = std::make_unique<Entry>();
+    entry->isFont = isFont;
+    // The font object exists from the start so callers can keep references
+    if (isFont) entry->font = std::make_unique<sf::Font>();
+    Entry& e = *entry;
+    entries.emplace(path, std::move(entry));
+    queue.push_back(path);
+    wake.notify_one();
+    return e;
+}
+
+const sf::Font& AssetCache::font(const std::string& path) {
+    return *find(path, true).font;
+}
+
+const sf::Texture* AssetCache::texture(const std::string& path) {
+    Entry& e = find(path, false);
+    std::lock_guard<std::mutex> lock(mutex);
+    return e.state == State::Ready ? e.texture.get() : nullptr;
+}
+
+void AssetCache::prefetch(const std::vector<std::string>& paths) {
+    for (const auto& path : paths) find(path, false);
+}
+
+int AssetCache::poll() {
+    // Entries in Decoded state are no longer touched by the loader
+    std::vector<std::pair<const std::string*, Entry*>> decoded;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [path, entry] : entries)
+            if (entry->state == State::Decoded) decoded.emplace_back(&path, entry.get());
+    }
+    int ready = 0;
+    for (auto& [path, e] : decoded) {
+        bool ok;
+        if (e->isFont) {
+            ok = e->font->loadFromMemory(e->bytes.data(), e->bytes.size());
+        }
+        else {
+            auto texture = std::make_unique<sf::Texture>();
+            ok = texture->loadFromImage(e->image);
+            if (ok) {
+                texture->setSmooth(true);
+                e->texture = std::move(texture);
+            }
+            e->image = sf::Image();
+        }
+        if (!ok) std::cerr << "Failed to load " << (e->isFont ? "font " : "texture ") << *path << "\n";
+        std::lock_guard<std::mutex> lock(mutex);
+        e->state = ok ? State::Ready : State::Failed;
+        ready += ok;
+    }
+    return ready;
+}
+
+std::size_t AssetCache::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t n = 0;
+    for (const auto& [path, entry] : entries)
+        n += entry->state == State::Queued || entry->state == State::Decoded;
+    return n;
+}
+
+void AssetCache::loaderLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        const std::string path = queue.front();
+        queue.pop_front();
+        Entry& e = *entries.at(path);
+        const bool isFont = e.isFont;
+        lock.unlock();
+
+        // Disk reads and image decoding need no GL context
+        bool ok;
+        sf::Image image;
+        std::vector<char> bytes;
+        if (isFont) {
+            std::ifstream in(path, std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            ok = !bytes.empty();
+        }
+        else {
+            ok = image.loadFromFile(path);
+        }
+
+        lock.lock();
+        if (ok) {
+            e.image = std::move(image);
+            e.bytes = std::move(bytes);
+            e.state = State::Decoded;
+        }
+        else {
+            std::cerr << "Failed to load " << path << "\n";
+            e.state = State::Failed;
+        }
+    }
+}
+
+AssetCache& assets() {
+    // Never destroyed: textures released after the last GL context at exit
+    // would be freed against nothing
+    static AssetCache* cache = new AssetCache();
+    return *cache;
+}
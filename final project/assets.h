@@ -0,0 +1,63 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Process-wide cache of fonts and textures. Files are read and decoded on a
+// background thread; poll() then opens fonts and uploads textures on the
+// main thread, which owns the GL context. Until an asset is ready callers
+// draw a placeholder, so windows open without waiting on the disk. Entries
+// stay loaded for the life of the process, so re-entering a simulation
+// from the menu does no I/O.
+class AssetCache {
+public:
+    AssetCache();
+    ~AssetCache();
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    // The font at path, queued on first use. It draws nothing until loaded;
+    // the reference stays valid, so sf::Text can hold it from the start.
+    const sf::Font& font(const std::string& path);
+    // The texture at path once uploaded, else nullptr; queued on first use.
+    const sf::Texture* texture(const std::string& path);
+    // Queues textures ahead of the first texture() call.
+    void prefetch(const std::vector<std::string>& paths);
+
+    // Finishes every asset the loader has decoded. Call once per frame from
+    // the thread that draws; returns how many became ready.
+    int poll();
+    // Assets queued or decoded but not yet ready.
+    std::size_t pending() const;
+
+private:
+    enum class State { Queued, Decoded, Ready, Failed };
+    struct Entry {
+        bool isFont = false;
+        State state = State::Queued;
+        sf::Image image;              // decoded texture, until uploaded
+        std::vector<char> bytes;      // font file; sf::Font reads from it for its whole life
+        std::unique_ptr<sf::Font> font;
+        std::unique_ptr<sf::Texture> texture;
+    };
+
+    Entry& find(const std::string& path, bool isFont);
+    void loaderLoop();
+
+    std::map<std::string, std::unique_ptr<Entry>> entries;
+    std::deque<std::string> queue;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread loader;
+    bool stopping = false;
+};
+
+// Process-wide cache, created on first use.
+AssetCache& assets();
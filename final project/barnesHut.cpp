@@ -0,0 +1,140 @@
+#include "barnesHut.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Coincident bodies would otherwise split forever
+    constexpr int MAX_DEPTH = 40;
+}
+
+int BarnesHutTree::makeNode(float cx, float cy, float half) {
+    nodes.push_back({ cx, cy, half, 0.f, 0.f, 0.f, -1, -1, -1 });
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+int BarnesHutTree::childFor(const Node& node, float px, float py) const {
+    return node.firstChild + (px >= node.cx ? 1 : 0) + (py >= node.cy ? 2 : 0);
+}
+
+void BarnesHutTree::split(int n, const float* x, const float* y, const float* mass) {
+    const float h = nodes[n].half * 0.5f;
+    const float cx = nodes[n].cx, cy = nodes[n].cy;
+    const int first = makeNode(cx - h, cy - h, h);
+    makeNode(cx + h, cy - h, h);
+    makeNode(cx - h, cy + h, h);
+    makeNode(cx + h, cy + h, h);
+    nodes[n].firstChild = first;
+
+    // Push the resident body down into its child
+    const int j = nodes[n].body;
+    nodes[n].body = nodes[n].head = -1;
+    Node& child = nodes[childFor(nodes[n], x[j], y[j])];
+    child.body = child.head = j;
+    child.mass = mass[j];
+    child.comX = mass[j] * x[j];
+    child.comY = mass[j] * y[j];
+}
+
+void BarnesHutTree::build(const float* x, const float* y, const float* mass, int count) {
+    nodes.clear();
+    nextInLeaf.assign(count, -1);
+    float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+    bool any = false;
+    for (int i = 0; i < count; ++i) {
+        if (mass[i] <= 0.f) continue;
+        if (!any) { minX = maxX = x[i]; minY = maxY = y[i]; any = true; }
+        minX = std::min(minX, x[i]); maxX = std::max(maxX, x[i]);
+        minY = std::min(minY, y[i]); maxY = std::max(maxY, y[i]);
+    }
+    const float half = std::max(maxX - minX, maxY - minY) * 0.5f + 1.f;
+    makeNode((minX + maxX) * 0.5f, (minY + maxY) * 0.5f, half);
+    if (!any) return;
+
+    for (int i = 0; i < count; ++i) {
+        const float m = mass[i];
+        if (m <= 0.f) continue;
+        int n = 0;
+        for (int depth = 0;; ++depth) {
+            // Accumulate on the way down; children are finished when reached
+            if (nodes[n].firstChild < 0 && nodes[n].body == -1 && nodes[n].mass == 0.f) {
+                nodes[n].body = nodes[n].head = i;
+                nodes[n].mass = m;
+                nodes[n].comX = m * x[i];
+                nodes[n].comY = m * y[i];
+                break;
+            }
+            if (nodes[n].firstChild < 0 && depth >= MAX_DEPTH) {
+                nodes[n].body = -2;
+                nextInLeaf[i] = nodes[n].head;
+                nodes[n].head = i;
+                nodes[n].mass += m;
+                nodes[n].comX += m * x[i];
+                nodes[n].comY += m * y[i];
+                break;
+            }
+            if (nodes[n].firstChild < 0)
+                split(n, x, y, mass);
+            nodes[n].mass += m;
+            nodes[n].comX += m * x[i];
+            nodes[n].comY += m * y[i];
+            n = childFor(nodes[n], x[i], y[i]);
+        }
+    }
+
+    for (Node& node : nodes) {
+        if (node.mass > 0.f) {
+            node.comX /= node.mass;
+            node.comY /= node.mass;
+        }
+    }
+}
+
+void BarnesHutTree::accel(float px, float py, int self, float theta, float eps2,
+    float& ax, float& ay) const {
+    ax = ay = 0.f;
+    if (nodes.empty()) return;
+    const float theta2 = theta * theta;
+    // Depth-first: at most three siblings wait per level
+    int stack[4 * (MAX_DEPTH + 2)];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.mass <= 0.f) continue;
+        const float dx = node.comX - px, dy = node.comY - py;
+        const float d2 = dx * dx + dy * dy;
+        const float size = 2.f * node.half;
+        if (node.firstChild < 0 || size * size < theta2 * d2) {
+            if (self >= 0 && node.body == self) continue;
+            const float r2 = d2 + eps2;
+            const float inv = node.mass / (r2 * std::sqrt(r2));
+            ax += dx * inv;
+            ay += dy * inv;
+        }
+        else {
+            for (int c = 0; c < 4; ++c)
+                stack[top++] = node.firstChild + c;
+        }
+    }
+}
+
+void BarnesHutTree::query(float minX, float minY, float maxX, float maxY, std::vector<int>& out) const {
+    if (nodes.empty()) return;
+    int stack[4 * (MAX_DEPTH + 2)];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (node.mass <= 0.f) continue;
+        if (node.cx + node.half < minX || node.cx - node.half > maxX
+            || node.cy + node.half < minY || node.cy - node.half > maxY) continue;
+        if (node.firstChild < 0) {
+            for (int b = node.head; b >= 0; b = nextInLeaf[b])
+                out.push_back(b);
+        }
+        else {
+            for (int c = 0; c < 4; ++c)
+                stack[top++] = node.firstChild + c;
+        }
+    }
+}
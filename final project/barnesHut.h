@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "memoryUsage.h"
+
+// Quadtree over point masses for O(n log n) gravity. Every node stores the
+// total mass and centre of mass of its subtree; a node is used as a single
+// point mass when (size / distance) < theta, otherwise it is opened.
+class BarnesHutTree {
+public:
+    // Bodies with zero mass are skipped: they feel gravity but do not source it.
+    void build(const float* x, const float* y, const float* mass, int count);
+
+    // Acceleration at (px, py) with G = 1, ignoring body `self` (-1 for none).
+    // eps2 is the squared softening length. Safe to call from many threads.
+    void accel(float px, float py, int self, float theta, float eps2,
+        float& ax, float& ay) const;
+
+    // Appends to `out` every body in a leaf whose cell touches the rect, so a
+    // superset of the bodies built inside it; the caller tests the positions.
+    // Massless bodies are not in the tree and never reported.
+    void query(float minX, float minY, float maxX, float maxY, std::vector<int>& out) const;
+
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t memoryBytes() const { return capacityBytes(nodes, nextInLeaf); }
+
+private:
+    struct Node {
+        float cx, cy, half;    // square cell centre and half size
+        float mass;
+        float comX, comY;      // mass-weighted sums while building, centre of mass after
+        int firstChild;        // four consecutive children, -1 for a leaf
+        int body;              // leaf body, -1 empty, -2 several (depth limit)
+        int head;              // first body of the leaf, then along nextInLeaf; -1 none
+    };
+
+    int makeNode(float cx, float cy, float half);
+    void split(int n, const float* x, const float* y, const float* mass);
+    int childFor(const Node& node, float px, float py) const;
+
+    std::vector<Node> nodes;
+    std::vector<int> nextInLeaf; // per body: the leaf's next body, -1 last
+};
@@ -0,0 +1,88 @@
+#include "circleBatch.h"
+#include <algorithm>
+#include <cmath>
+
+const sf::Texture& circleTexture() {
+    static sf::Texture texture;
+    static bool created = false;
+    if (!created) {
+        sf::Image img;
+        img.create(CircleBatch::DISC_SIZE, CircleBatch::DISC_SIZE, sf::Color::Transparent);
+        const float c = CircleBatch::DISC_SIZE / 2.f;
+        for (unsigned y = 0; y < CircleBatch::DISC_SIZE; ++y) {
+            for (unsigned x = 0; x < CircleBatch::DISC_SIZE; ++x) {
+                float d = std::hypot(x + 0.5f - c, y + 0.5f - c);
+                float a = std::clamp(c - d, 0.f, 1.f); // one texel of edge falloff
+                img.setPixel(x, y, sf::Color(255, 255, 255, static_cast<sf::Uint8>(255 * a)));
+            }
+        }
+        texture.loadFromImage(img);
+        texture.setSmooth(true);
+        texture.generateMipmap();
+        created = true;
+    }
+    return texture;
+}
+
+CircleBatch::CircleBatch(sf::VertexBuffer::Usage usage)
+    : buffer(sf::Triangles, usage), useBuffer(sf::VertexBuffer::isAvailable())
+{
+}
+
+void CircleBatch::add(float x, float y, float r, sf::Color color) {
+    const float t = static_cast<float>(DISC_SIZE);
+    sf::Vertex quad[6];
+    for (auto& v : quad) v.color = color;
+    vertices.insert(vertices.end(), quad, quad + 6);
+    // Texture coordinates never change, so set() only rewrites positions
+    sf::Vertex* v = &vertices[vertices.size() - 6];
+    v[0].texCoords = { 0.f, 0.f }; v[1].texCoords = { t, 0.f }; v[2].texCoords = { t, t };
+    v[3].texCoords = { 0.f, 0.f }; v[4].texCoords = { t, t };   v[5].texCoords = { 0.f, t };
+    set(size() - 1, x, y, r);
+}
+
+void CircleBatch::set(std::size_t i, float x, float y, float r) {
+    sf::Vertex* v = &vertices[i * 6];
+    v[0].position = { x - r, y - r }; v[1].position = { x + r, y - r }; v[2].position = { x + r, y + r };
+    v[3].position = { x - r, y - r }; v[4].position = { x + r, y + r }; v[5].position = { x - r, y + r };
+}
+
+void CircleBatch::upload() {
+    uploaded = vertices.size();
+    if (!useBuffer || uploaded == 0) return;
+    if (buffer.getVertexCount() < uploaded) {
+        // Grow geometrically so steady-state frames only stream, never reallocate
+        std::size_t capacity = std::max<std::size_t>(uploaded, buffer.getVertexCount() * 2);
+        if (!buffer.create(capacity)) {
+            useBuffer = false;
+            return;
+        }
+    }
+    buffer.update(vertices.data(), uploaded, 0);
+}
+
+bool CircleBatch::resizeOnGpu(std::size_t circles) {
+    vertices.clear();
+    uploaded = 0;
+    if (!useBuffer) return false;
+    const std::size_t needed = circles * 6;
+    if (buffer.getVertexCount() < needed) {
+        std::size_t capacity = std::max<std::size_t>(needed, buffer.getVertexCount() * 2);
+        if (!buffer.create(capacity)) {
+            useBuffer = false;
+            return false;
+        }
+    }
+    uploaded = needed;
+    return true;
+}
+
+void CircleBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (uploaded == 0) return;
+    states.texture = &circleTexture();
+    states.blendMode = blendMode;
+    if (useBuffer)
+        target.draw(buffer, 0, uploaded, states);
+    else
+        target.draw(vertices.data(), uploaded, sf::Triangles, states);
+}
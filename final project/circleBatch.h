@@ -0,0 +1,42 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+// Packs every circle of one material (disc texture + blend mode) into a single
+// persistent vertex buffer so a whole scene is drawn with one draw call.
+// Each circle is a textured quad (two triangles) sampling a shared disc texture.
+class CircleBatch : public sf::Drawable {
+public:
+    static constexpr unsigned DISC_SIZE = 64; // side of circleTexture(), in texels
+
+    explicit CircleBatch(sf::VertexBuffer::Usage usage = sf::VertexBuffer::Stream);
+
+    void clear() { vertices.clear(); }
+    void reserve(std::size_t circles) { vertices.reserve(circles * 6); }
+    void add(float x, float y, float r, sf::Color color);
+    // Moves circle i without touching its color; i must already exist.
+    void set(std::size_t i, float x, float y, float r);
+
+    // Streams the CPU-side vertices into the GPU buffer; call once per frame.
+    void upload();
+    // For a compute shader to fill instead (see gpuCollision.h): sizes the
+    // GPU buffer for `circles` and draws that many from it, without the
+    // CPU-side vertices. False where vertex buffers are unavailable.
+    bool resizeOnGpu(std::size_t circles);
+    unsigned nativeBuffer() const { return buffer.getNativeHandle(); }
+
+    std::size_t size() const { return vertices.size() / 6; }
+    sf::BlendMode blendMode = sf::BlendAlpha;
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    std::vector<sf::Vertex> vertices;
+    sf::VertexBuffer buffer;
+    std::size_t uploaded = 0;
+    bool useBuffer;
+};
+
+// Shared anti-aliased white disc, created on first use.
+const sf::Texture& circleTexture();
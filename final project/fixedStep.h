@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+
+// Fixed-timestep accumulator shared by all simulations. Physics always
+// advances in steps of dt(), and at most maxSubsteps steps per frame, so a
+// slow frame cannot feed a huge dt into integration. Leftover time carries
+// over to the next frame and is exposed as alpha() to interpolate rendering.
+class FixedStep {
+public:
+    explicit FixedStep(float hz = 240.f, int maxSubsteps = 8)
+        : step(1.f / hz), maxSteps(maxSubsteps)
+    {
+    }
+
+    // Adds one frame's wall time and returns how many physics steps to run.
+    int advance(float frameSeconds) {
+        accumulator += frameSeconds;
+        int steps = static_cast<int>(accumulator / step);
+        if (steps > maxSteps) {
+            // Too far behind: drop the backlog instead of spiralling
+            steps = maxSteps;
+            accumulator = 0.f;
+        }
+        else {
+            accumulator -= steps * step;
+        }
+        return steps;
+    }
+
+    void reset() { accumulator = 0.f; }
+
+    float dt() const { return step; }
+    // Fraction of a step between the last physics state and "now", in [0, 1)
+    float alpha() const { return std::min(accumulator / step, 1.f); }
+
+private:
+    float step;
+    int maxSteps;
+    float accumulator = 0.f;
+};
+
+inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
@@ -0,0 +1,59 @@
+#include "frameArena.h"
+#include <algorithm>
+#include <cstdint>
+
+void* FrameArena::allocate(std::size_t bytes, std::size_t align) {
+    while (true) {
+        if (current < blocks.size()) {
+            Block& b = blocks[current];
+            const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(b.data.get());
+            const std::size_t start = ((base + offset + align - 1) & ~(std::uintptr_t)(align - 1)) - base;
+            if (start + bytes <= b.size) {
+                inUse = usedBefore + start + bytes;
+                peak = std::max(peak, inUse);
+                offset = start + bytes;
+                return b.data.get() + start;
+            }
+            // Move on to the next block, (re)using it if it is big enough
+            usedBefore += b.size;
+            ++current;
+            offset = 0;
+            if (current < blocks.size() && blocks[current].size >= bytes + align) continue;
+            blocks.resize(current); // later blocks were too small
+        }
+        const std::size_t last = blocks.empty() ? FIRST_BLOCK / 2 : blocks.back().size;
+        Block b;
+        b.size = std::max(2 * last, bytes + align);
+        b.data.reset(new unsigned char[b.size]);
+        blocks.push_back(std::move(b));
+    }
+}
+
+void FrameArena::rewind(Mark m) {
+    current = m.block;
+    offset = m.offset;
+    usedBefore = 0;
+    for (std::size_t i = 0; i < current && i < blocks.size(); ++i)
+        usedBefore += blocks[i].size;
+    inUse = usedBefore + offset;
+    if (current > 0 || offset > 0 || blocks.size() < 2) return;
+
+    // Back to empty after spilling into several blocks: replace them with one
+    // that holds the whole burst next time
+    Block merged;
+    merged.size = capacity();
+    merged.data.reset(new unsigned char[merged.size]);
+    blocks.clear();
+    blocks.push_back(std::move(merged));
+}
+
+std::size_t FrameArena::capacity() const {
+    std::size_t total = 0;
+    for (const Block& b : blocks) total += b.size;
+    return total;
+}
+
+FrameArena& frameArena() {
+    thread_local FrameArena arena;
+    return arena;
+}
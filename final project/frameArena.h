@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Bump allocator for scratch that lives no longer than one step. Each thread
+// has its own (frameArena()), so allocating is a pointer bump with no locks.
+// ArenaScope releases everything allocated inside it at once. When a burst
+// outgrows the arena it chains extra blocks, and once the outermost scope
+// closes they are merged into one block big enough for the whole burst, so
+// a scene whose step sizes have settled never reaches the global heap.
+class FrameArena {
+public:
+    static constexpr std::size_t FIRST_BLOCK = 256 * 1024;
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t align);
+
+    struct Mark {
+        std::size_t block = 0, offset = 0;
+    };
+    Mark mark() const { return { current, offset }; }
+    // Frees everything allocated since m was taken.
+    void rewind(Mark m);
+
+    // Bytes reserved, and the most ever in use at once.
+    std::size_t capacity() const;
+    std::size_t highWater() const { return peak; }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        std::size_t size = 0;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t current = 0, offset = 0; // next free byte
+    std::size_t inUse = 0, peak = 0;
+    std::size_t usedBefore = 0;           // bytes in blocks before current
+};
+
+// The calling thread's arena.
+FrameArena& frameArena();
+
+// Frees the arena allocations made during its lifetime.
+class ArenaScope {
+public:
+    explicit ArenaScope(FrameArena& a = frameArena()) : arena(a), start(a.mark()) {}
+    ~ArenaScope() { arena.rewind(start); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    FrameArena& arena;
+    FrameArena::Mark start;
+};
+
+// Standard allocator drawing from an arena. deallocate() is a no-op; the
+// memory comes back when the enclosing ArenaScope closes, so containers using
+// it must not outlive that scope.
+template <class T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() : arena(&frameArena()) {}
+    explicit ArenaAllocator(FrameArena& a) : arena(&a) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, std::size_t) {}
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <class U> friend class ArenaAllocator;
+    FrameArena* arena;
+};
+
+// Step-local vector on this thread's arena: declare it inside an ArenaScope.
+template <class T>
+using FrameVector = std::vector<T, ArenaAllocator<T>>;
@@ -0,0 +1,78 @@
+#include "glCompute.h"
+#include <cstring>
+
+namespace {
+    template <typename F>
+    bool load(F& fn, const char* name) {
+        const sf::Context::GlFunctionPointer p = sf::Context::getFunction(name);
+        std::memcpy(&fn, &p, sizeof fn);
+        return p != nullptr;
+    }
+
+    bool loadAll(gl43::Api& gl) {
+        return load(gl.createShader, "glCreateShader") && load(gl.shaderSource, "glShaderSource") &&
+            load(gl.compileShader, "glCompileShader") && load(gl.getShaderiv, "glGetShaderiv") &&
+            load(gl.getShaderInfoLog, "glGetShaderInfoLog") && load(gl.deleteShader, "glDeleteShader") &&
+            load(gl.createProgram, "glCreateProgram") && load(gl.attachShader, "glAttachShader") &&
+            load(gl.linkProgram, "glLinkProgram") && load(gl.getProgramiv, "glGetProgramiv") &&
+            load(gl.getProgramInfoLog, "glGetProgramInfoLog") && load(gl.deleteProgram, "glDeleteProgram") &&
+            load(gl.useProgram, "glUseProgram") && load(gl.getUniformLocation, "glGetUniformLocation") &&
+            load(gl.uniform1i, "glUniform1i") && load(gl.uniform1ui, "glUniform1ui") &&
+            load(gl.uniform1f, "glUniform1f") && load(gl.uniform2f, "glUniform2f") &&
+            load(gl.uniform4f, "glUniform4f") &&
+            load(gl.genBuffers, "glGenBuffers") && load(gl.deleteBuffers, "glDeleteBuffers") &&
+            load(gl.bindBuffer, "glBindBuffer") && load(gl.bufferData, "glBufferData") &&
+            load(gl.bufferSubData, "glBufferSubData") && load(gl.getBufferSubData, "glGetBufferSubData") &&
+            load(gl.clearBufferData, "glClearBufferData") &&
+            load(gl.bindBufferBase, "glBindBufferBase") && load(gl.dispatchCompute, "glDispatchCompute") &&
+            load(gl.memoryBarrier, "glMemoryBarrier") && load(gl.finish, "glFinish");
+    }
+
+    std::string infoLog(const gl43::Api& gl, GLuint object, bool isProgram) {
+        GLint length = 0;
+        (isProgram ? gl.getProgramiv : gl.getShaderiv)(object, gl43::INFO_LOG_LENGTH, &length);
+        std::string log(static_cast<std::size_t>(length > 0 ? length : 1), '\0');
+        (isProgram ? gl.getProgramInfoLog : gl.getShaderInfoLog)(object, length, nullptr, &log[0]);
+        log.resize(std::strlen(log.c_str()));
+        return log;
+    }
+}
+
+const gl43::Api* gl43::load(const sf::Context& context, std::string& failure) {
+    const sf::ContextSettings settings = context.getSettings();
+    if (settings.majorVersion * 10 + settings.minorVersion < 43) {
+        failure = "needs OpenGL 4.3 for compute shaders";
+        return nullptr;
+    }
+    static Api gl;
+    static const bool loaded = loadAll(gl);
+    if (!loaded) {
+        failure = "driver lacks the compute entry points";
+        return nullptr;
+    }
+    return &gl;
+}
+
+GLuint gl43::buildProgram(const Api& gl, const char* source, const char* what, std::string& failure) {
+    const GLuint shader = gl.createShader(COMPUTE_SHADER);
+    gl.shaderSource(shader, 1, &source, nullptr);
+    gl.compileShader(shader);
+    GLint ok = 0;
+    gl.getShaderiv(shader, COMPILE_STATUS, &ok);
+    if (!ok) {
+        failure = std::string(what) + " shader: " + infoLog(gl, shader, false);
+        gl.deleteShader(shader);
+        return 0;
+    }
+    const GLuint program = gl.createProgram();
+    gl.attachShader(program, shader);
+    gl.linkProgram(program);
+    gl.deleteShader(shader);
+    gl.getProgramiv(program, LINK_STATUS, &ok);
+    if (!ok) {
+        failure = std::string(what) + " program: " + infoLog(gl, program, true);
+        gl.deleteProgram(program);
+        return 0;
+    }
+    return program;
+}
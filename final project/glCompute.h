@@ -0,0 +1,70 @@
+#pragma once
+#include <SFML/OpenGL.hpp>
+#include <SFML/Window.hpp>
+#include <cstddef>
+#include <string>
+
+// OpenGL 4.3 compute entry points for the GPU paths (gpuForces.h,
+// gpuCollision.h), loaded through SFML so no loader library is needed.
+// Names SFML's headers stop short of are spelled without the GL_ prefix,
+// so they can coexist with the glext.h macros.
+namespace gl43 {
+    using Char = char;
+    using Sizeiptr = std::ptrdiff_t;
+    using Intptr = std::ptrdiff_t;
+    constexpr GLenum COMPUTE_SHADER = 0x91B9;
+    constexpr GLenum COMPILE_STATUS = 0x8B81;
+    constexpr GLenum LINK_STATUS = 0x8B82;
+    constexpr GLenum INFO_LOG_LENGTH = 0x8B84;
+    constexpr GLenum SHADER_STORAGE_BUFFER = 0x90D2;
+    constexpr GLenum DYNAMIC_DRAW = 0x88E8;
+    constexpr GLenum DYNAMIC_COPY = 0x88EA;
+    constexpr GLenum R32UI = 0x8236;
+    constexpr GLenum RED_INTEGER = 0x8D94;
+    constexpr GLenum UNSIGNED_INT = 0x1405;
+    constexpr GLbitfield VERTEX_ATTRIB_ARRAY_BARRIER_BIT = 0x00000001;
+    constexpr GLbitfield BUFFER_UPDATE_BARRIER_BIT = 0x00000200;
+    constexpr GLbitfield SHADER_STORAGE_BARRIER_BIT = 0x00002000;
+
+    struct Api {
+        GLuint (APIENTRY* createShader)(GLenum);
+        void (APIENTRY* shaderSource)(GLuint, GLsizei, const Char* const*, const GLint*);
+        void (APIENTRY* compileShader)(GLuint);
+        void (APIENTRY* getShaderiv)(GLuint, GLenum, GLint*);
+        void (APIENTRY* getShaderInfoLog)(GLuint, GLsizei, GLsizei*, Char*);
+        void (APIENTRY* deleteShader)(GLuint);
+        GLuint (APIENTRY* createProgram)();
+        void (APIENTRY* attachShader)(GLuint, GLuint);
+        void (APIENTRY* linkProgram)(GLuint);
+        void (APIENTRY* getProgramiv)(GLuint, GLenum, GLint*);
+        void (APIENTRY* getProgramInfoLog)(GLuint, GLsizei, GLsizei*, Char*);
+        void (APIENTRY* deleteProgram)(GLuint);
+        void (APIENTRY* useProgram)(GLuint);
+        GLint (APIENTRY* getUniformLocation)(GLuint, const Char*);
+        void (APIENTRY* uniform1i)(GLint, GLint);
+        void (APIENTRY* uniform1ui)(GLint, GLuint);
+        void (APIENTRY* uniform1f)(GLint, GLfloat);
+        void (APIENTRY* uniform2f)(GLint, GLfloat, GLfloat);
+        void (APIENTRY* uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
+        void (APIENTRY* genBuffers)(GLsizei, GLuint*);
+        void (APIENTRY* deleteBuffers)(GLsizei, const GLuint*);
+        void (APIENTRY* bindBuffer)(GLenum, GLuint);
+        void (APIENTRY* bufferData)(GLenum, Sizeiptr, const void*, GLenum);
+        void (APIENTRY* bufferSubData)(GLenum, Intptr, Sizeiptr, const void*);
+        void (APIENTRY* getBufferSubData)(GLenum, Intptr, Sizeiptr, void*);
+        void (APIENTRY* clearBufferData)(GLenum, GLenum, GLenum, GLenum, const void*);
+        void (APIENTRY* bindBufferBase)(GLenum, GLuint, GLuint);
+        void (APIENTRY* dispatchCompute)(GLuint, GLuint, GLuint);
+        void (APIENTRY* memoryBarrier)(GLbitfield);
+        void (APIENTRY* finish)();
+    };
+
+    // The entry points, loaded once from the first context that asks; null,
+    // with the reason in `failure`, when `context` is older than GL 4.3 or
+    // the driver lacks any of them. Needs `context` current.
+    const Api* load(const sf::Context& context, std::string& failure);
+
+    // Compiles and links one compute shader; 0, with `what` and the driver's
+    // log in `failure`, when either fails.
+    GLuint buildProgram(const Api& gl, const char* source, const char* what, std::string& failure);
+}
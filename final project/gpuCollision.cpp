@@ -0,0 +1,446 @@
+#include "gpuCollision.h"
+#include <algorithm>
+#include <cmath>
+#include "circleBatch.h"
+#include "glCompute.h"
+
+namespace {
+    constexpr int GROUP_SIZE = 256;  // invocations per work group of the per-ball passes
+    constexpr int FLOATS_PER_BALL = 8;
+    // Jacobi passes per step over one grid. Eight keep a settled pile's
+    // energy within a percent of the sequential CPU solve
+    constexpr int SOLVER_PASSES = 8;
+
+    // Bindings: 0 live balls, 1 solved balls, 2 per-cell counts (then the
+    // scatter cursors), 3 cell starts, 4 ball indices sorted by cell,
+    // 5 counters, 6 vertices being drawn.
+    const char* const COMMON = R"(
+        #version 430
+        struct Ball { vec2 pos; vec2 vel; vec2 prev; float radius; float invMass; };
+        uniform int count;
+        uniform vec2 gridOrigin;
+        uniform float invCell;
+        uniform int cols;
+        uniform int rows;
+
+        // Balls outside the grid clamp into its edge cells, so overlapping
+        // balls still land in neighbouring cells
+        ivec2 cellXY(vec2 p) {
+            ivec2 c = ivec2(floor((p - gridOrigin) * invCell));
+            return clamp(c, ivec2(0), ivec2(cols - 1, rows - 1));
+        }
+        int cellOf(vec2 p) { ivec2 c = cellXY(p); return c.y * cols + c.x; }
+    )";
+
+    // CollisionWorld's field and walls for one ball: semi-implicit Euler
+    // with drag, then the wall clamp of driftCollideWalls
+    const char* const INTEGRATE_SHADER = R"(
+        layout(local_size_x = 256) in;
+        layout(std430, binding = 0) buffer Balls { Ball ball[]; };
+        layout(std430, binding = 2) buffer CellCount { uint cellCount[]; };
+        uniform float dt;
+        uniform float gravity;
+        uniform int dragModel; // 0 none, 1 linear, 2 quadratic
+        uniform float drag;
+        uniform int walls;     // 0 box, 1 open
+        uniform float restitution;
+        uniform vec4 box;      // left, top, right, bottom
+
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            if (i >= uint(count)) return;
+            Ball b = ball[i];
+            b.prev = b.pos;
+            float k = dragModel == 0 ? 0.0 : dragModel == 1 ? drag : drag * length(b.vel);
+            b.vel += (vec2(0.0, gravity) - k * b.vel) * dt;
+            b.pos += b.vel * dt;
+            if (walls == 0) {
+                float e = -restitution;
+                if (b.pos.x - b.radius < box.x) { b.pos.x = box.x + b.radius; b.vel.x *= e; }
+                if (b.pos.x + b.radius > box.z) { b.pos.x = box.z - b.radius; b.vel.x *= e; }
+                if (b.pos.y - b.radius < box.y) { b.pos.y = box.y + b.radius; b.vel.y *= e; }
+                if (b.pos.y + b.radius > box.w) { b.pos.y = box.w - b.radius; b.vel.y *= e; }
+            }
+            ball[i] = b;
+            atomicAdd(cellCount[cellOf(b.pos)], 1u);
+        }
+    )";
+
+    // Exclusive prefix sum of the cell counts in one work group: every
+    // invocation sums a run of cells, the run totals are scanned in shared
+    // memory, then each run is written out. The counts go back to zero to
+    // serve as the scatter's cursors, as do the last step's counters.
+    const char* const SCAN_SHADER = R"(
+        layout(local_size_x = 1024) in;
+        layout(std430, binding = 2) buffer CellCount { uint cellCount[]; };
+        layout(std430, binding = 3) writeonly buffer CellStart { uint cellStart[]; };
+        layout(std430, binding = 5) buffer Counters { uint counter[]; };
+        uniform int cells;
+        shared uint partial[1024];
+
+        void main() {
+            uint t = gl_LocalInvocationID.x;
+            uint per = (uint(cells) + 1023u) / 1024u;
+            uint begin = min(t * per, uint(cells)), end = min(begin + per, uint(cells));
+            uint sum = 0u;
+            for (uint c = begin; c < end; ++c) sum += cellCount[c];
+            partial[t] = sum;
+            barrier();
+            for (uint offset = 1u; offset < 1024u; offset <<= 1) {
+                uint add = t >= offset ? partial[t - offset] : 0u;
+                barrier();
+                partial[t] += add;
+                barrier();
+            }
+            uint run = t > 0u ? partial[t - 1u] : 0u;
+            for (uint c = begin; c < end; ++c) {
+                cellStart[c] = run;
+                run += cellCount[c];
+                cellCount[c] = 0u;
+            }
+            if (t == 1023u) cellStart[cells] = partial[1023];
+            if (t == 0u) { counter[0] = 0u; counter[1] = 0u; }
+        }
+    )";
+
+    const char* const SCATTER_SHADER = R"(
+        layout(local_size_x = 256) in;
+        layout(std430, binding = 0) readonly buffer Balls { Ball ball[]; };
+        layout(std430, binding = 2) buffer CellCount { uint cellCount[]; };
+        layout(std430, binding = 3) readonly buffer CellStart { uint cellStart[]; };
+        layout(std430, binding = 4) writeonly buffer Sorted { uint sorted[]; };
+
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            if (i >= uint(count)) return;
+            int c = cellOf(ball[i].pos);
+            sorted[cellStart[c] + atomicAdd(cellCount[c], 1u)] = i;
+        }
+    )";
+
+    // Every ball against the 3x3 cells around it, with resolveContact's
+    // impulse and push applied to its own side only; the pair's other side
+    // is the neighbour's invocation. Reads one copy and writes the other, so
+    // every ball sees its neighbours as they were after integration.
+    const char* const SOLVE_SHADER = R"(
+        layout(local_size_x = 256) in;
+        layout(std430, binding = 0) readonly buffer Balls { Ball ball[]; };
+        layout(std430, binding = 1) writeonly buffer Solved { Ball solved[]; };
+        layout(std430, binding = 3) readonly buffer CellStart { uint cellStart[]; };
+        layout(std430, binding = 4) readonly buffer Sorted { uint sorted[]; };
+        layout(std430, binding = 5) buffer Counters { uint counter[]; };
+        uniform float restitution;
+        uniform int countPairs; // first pass of the step only
+        shared uint groupContacts, groupCandidates;
+
+        void main() {
+            if (gl_LocalInvocationIndex == 0u) { groupContacts = 0u; groupCandidates = 0u; }
+            barrier();
+            uint i = gl_GlobalInvocationID.x;
+            uint contacts = 0u, candidates = 0u;
+            if (i < uint(count)) {
+                Ball b = ball[i];
+                vec2 dv = vec2(0.0), dp = vec2(0.0);
+                uint resolved = 0u;
+                ivec2 home = cellXY(b.pos);
+                for (int y = max(home.y - 1, 0); y <= min(home.y + 1, rows - 1); ++y) {
+                    for (int x = max(home.x - 1, 0); x <= min(home.x + 1, cols - 1); ++x) {
+                        int c = y * cols + x;
+                        for (uint s = cellStart[c]; s < cellStart[c + 1]; ++s) {
+                            uint j = sorted[s];
+                            if (j == i) continue;
+                            Ball o = ball[j];
+                            vec2 d = o.pos - b.pos;
+                            float minD = b.radius + o.radius;
+                            if (abs(d.x) > minD || abs(d.y) > minD) continue;
+                            if (i < j) ++candidates;
+                            float dist2 = dot(d, d);
+                            if (dist2 >= minD * minD || dist2 <= 0.0) continue;
+                            if (i < j) ++contacts;
+                            float invSum = b.invMass + o.invMass;
+                            if (invSum <= 0.0) continue;
+                            float dist = sqrt(dist2);
+                            vec2 n = d / dist;
+                            float vrel = dot(b.vel - o.vel, n);
+                            if (vrel > 0.0) {
+                                dv -= (1.0 + restitution) * vrel / invSum * b.invMass * n;
+                                dp -= n * ((minD - dist) / invSum * b.invMass);
+                                ++resolved;
+                            }
+                        }
+                    }
+                }
+                // Averaged: summed, the corrections of a ball pressed from
+                // several sides overshoot and piles blow up
+                if (resolved > 0u) {
+                    b.vel += dv / float(resolved);
+                    b.pos += dp / float(resolved);
+                }
+                solved[i] = b;
+            }
+            if (contacts > 0u) atomicAdd(groupContacts, contacts);
+            if (candidates > 0u) atomicAdd(groupCandidates, candidates);
+            barrier();
+            if (gl_LocalInvocationIndex == 0u && countPairs != 0) {
+                atomicAdd(counter[0], groupContacts);
+                atomicAdd(counter[1], groupCandidates);
+                atomicAdd(counter[2], groupContacts);
+            }
+        }
+    )";
+
+    // CircleBatch's quad per ball, written as sf::Vertex (position, RGBA
+    // bytes, texture coordinates: five 32-bit words) in its vertex order
+    const char* const DRAW_SHADER = R"(
+        layout(local_size_x = 256) in;
+        layout(std430, binding = 0) readonly buffer Balls { Ball ball[]; };
+        layout(std430, binding = 6) writeonly buffer Vertices { uint vertex[]; };
+        uniform float alpha;
+        uniform uint color;
+        uniform float textureSize;
+
+        const vec2 CORNERS[6] = vec2[6](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+            vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            if (i >= uint(count)) return;
+            Ball b = ball[i];
+            vec2 p = mix(b.prev, b.pos, alpha);
+            for (uint k = 0u; k < 6u; ++k) {
+                uint v = (i * 6u + k) * 5u;
+                vec2 corner = CORNERS[k];
+                vertex[v] = floatBitsToUint(p.x + corner.x * b.radius);
+                vertex[v + 1u] = floatBitsToUint(p.y + corner.y * b.radius);
+                vertex[v + 2u] = color;
+                vertex[v + 3u] = floatBitsToUint((corner.x * 0.5 + 0.5) * textureSize);
+                vertex[v + 4u] = floatBitsToUint((corner.y * 0.5 + 0.5) * textureSize);
+            }
+        }
+    )";
+
+    const char* const UNIFORM_NAMES[] = {
+        "count", "gridOrigin", "invCell", "cols", "rows", "cells", "dt", "gravity", "dragModel", "drag",
+        "walls", "restitution", "box", "alpha", "color", "textureSize", "countPairs"
+    };
+
+    GLuint groups(std::size_t invocations) {
+        return GLuint((invocations + GROUP_SIZE - 1) / GROUP_SIZE);
+    }
+}
+
+GpuCollisionWorld::GpuCollisionWorld()
+    : context(sf::ContextSettings(0, 0, 0, 4, 3), 1, 1)
+{
+    gl = gl43::load(context, failure);
+    if (!gl) {
+        context.setActive(false);
+        return;
+    }
+    const struct { const char* source; const char* name; } stages[PROGRAMS] = {
+        { INTEGRATE_SHADER, "integrate" }, { SCAN_SHADER, "scan" }, { SCATTER_SHADER, "scatter" },
+        { SOLVE_SHADER, "solve" }, { DRAW_SHADER, "draw" }
+    };
+    GLuint built[PROGRAMS] = {};
+    for (int p = 0; p < PROGRAMS; ++p) {
+        const std::string source = std::string(COMMON) + stages[p].source;
+        built[p] = gl43::buildProgram(*gl, source.c_str(), stages[p].name, failure);
+        if (built[p]) continue;
+        for (int q = 0; q < p; ++q) gl->deleteProgram(built[q]);
+        context.setActive(false);
+        return;
+    }
+    // Names a program does not use come back as -1, which glUniform ignores
+    for (int p = 0; p < PROGRAMS; ++p) {
+        programs[p] = built[p];
+        for (int u = 0; u < UNIFORMS; ++u)
+            locations[p][u] = gl->getUniformLocation(built[p], UNIFORM_NAMES[u]);
+    }
+    gl->genBuffers(2, state);
+    gl->genBuffers(1, &cellCount);
+    gl->genBuffers(1, &cellStart);
+    gl->genBuffers(1, &sorted);
+    gl->genBuffers(1, &counterBuffer);
+    const GLuint zero[3] = {};
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, counterBuffer);
+    gl->bufferData(gl43::SHADER_STORAGE_BUFFER, sizeof zero, zero, gl43::DYNAMIC_COPY);
+    context.setActive(false);
+}
+
+GpuCollisionWorld::~GpuCollisionWorld() {
+    if (!ready()) return;
+    context.setActive(true);
+    gl->deleteBuffers(2, state);
+    gl->deleteBuffers(1, &cellCount);
+    gl->deleteBuffers(1, &cellStart);
+    gl->deleteBuffers(1, &sorted);
+    gl->deleteBuffers(1, &counterBuffer);
+    for (unsigned p : programs) gl->deleteProgram(p);
+    context.setActive(false);
+}
+
+bool GpuCollisionWorld::supports(const SceneConfig& config) {
+    return config.integrator == IntegratorKind::SemiImplicitEuler;
+}
+
+void GpuCollisionWorld::reserveBalls(std::size_t balls) {
+    if (balls <= ballCapacity) return;
+    // Grow by half again, so spawning in batches reallocates rarely. The
+    // live copy keeps its balls: upload() rewrites them right after
+    ballCapacity = balls + balls / 2;
+    for (unsigned buffer : state) {
+        gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, buffer);
+        gl->bufferData(gl43::SHADER_STORAGE_BUFFER, gl43::Sizeiptr(ballCapacity) * FLOATS_PER_BALL * sizeof(float),
+            nullptr, gl43::DYNAMIC_COPY);
+    }
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, sorted);
+    gl->bufferData(gl43::SHADER_STORAGE_BUFFER, gl43::Sizeiptr(ballCapacity) * sizeof(GLuint), nullptr, gl43::DYNAMIC_COPY);
+}
+
+void GpuCollisionWorld::reserveCells(int cells) {
+    if (cells <= cellCapacity) return;
+    cellCapacity = cells + cells / 2;
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, cellCount);
+    gl->bufferData(gl43::SHADER_STORAGE_BUFFER, gl43::Sizeiptr(cellCapacity) * sizeof(GLuint), nullptr, gl43::DYNAMIC_COPY);
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, cellStart);
+    gl->bufferData(gl43::SHADER_STORAGE_BUFFER, gl43::Sizeiptr(cellCapacity + 1) * sizeof(GLuint), nullptr, gl43::DYNAMIC_COPY);
+}
+
+void GpuCollisionWorld::upload(const ParticleStore& balls) {
+    if (!ready() || !context.setActive(true)) return;
+    count = balls.size();
+    reserveBalls(count);
+    staging.resize(count * FLOATS_PER_BALL);
+    maxRadius = 0.f;
+    for (std::size_t i = 0; i < count; ++i) {
+        float* b = &staging[i * FLOATS_PER_BALL];
+        b[0] = balls.x[i]; b[1] = balls.y[i];
+        b[2] = balls.vx[i]; b[3] = balls.vy[i];
+        b[4] = balls.prevX[i]; b[5] = balls.prevY[i];
+        b[6] = balls.radius[i]; b[7] = balls.invMass[i];
+        maxRadius = std::max(maxRadius, balls.radius[i]);
+    }
+    if (count > 0) {
+        gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, state[current]);
+        gl->bufferSubData(gl43::SHADER_STORAGE_BUFFER, 0, gl43::Sizeiptr(staging.size() * sizeof(float)), staging.data());
+    }
+
+    // Cells at least two radii wide, so only the 3x3 neighbourhood can touch
+    cellSize = std::max(2.f * maxRadius, 1.f);
+    cols = std::max(1, (int)std::ceil(bounds.width / cellSize));
+    rows = std::max(1, (int)std::ceil(bounds.height / cellSize));
+    reserveCells(cols * rows);
+    context.setActive(false);
+}
+
+void GpuCollisionWorld::download(ParticleStore& balls) {
+    if (!ready() || count == 0 || !context.setActive(true)) return;
+    gl->memoryBarrier(gl43::BUFFER_UPDATE_BARRIER_BIT);
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, state[current]);
+    gl->getBufferSubData(gl43::SHADER_STORAGE_BUFFER, 0, gl43::Sizeiptr(count * FLOATS_PER_BALL * sizeof(float)), staging.data());
+    context.setActive(false);
+    for (std::size_t i = 0; i < count && i < balls.size(); ++i) {
+        const float* b = &staging[i * FLOATS_PER_BALL];
+        balls.x[i] = b[0]; balls.y[i] = b[1];
+        balls.vx[i] = b[2]; balls.vy[i] = b[3];
+        balls.prevX[i] = b[4]; balls.prevY[i] = b[5];
+    }
+}
+
+void GpuCollisionWorld::setGrid(Program p) {
+    gl->useProgram(programs[p]);
+    gl->uniform1i(locations[p][COUNT], (GLint)count);
+    gl->uniform2f(locations[p][GRID_ORIGIN], bounds.left, bounds.top);
+    gl->uniform1f(locations[p][INV_CELL], 1.f / cellSize);
+    gl->uniform1i(locations[p][COLS], cols);
+    gl->uniform1i(locations[p][ROWS], rows);
+}
+
+void GpuCollisionWorld::step(float dt) {
+    if (!ready() || count == 0 || !context.setActive(true)) return;
+    const int cells = cols * rows;
+    const GLuint zero = 0;
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, cellCount);
+    gl->clearBufferData(gl43::SHADER_STORAGE_BUFFER, gl43::R32UI, gl43::RED_INTEGER, gl43::UNSIGNED_INT, &zero);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 0, state[current]);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 1, state[1 - current]);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 2, cellCount);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 3, cellStart);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 4, sorted);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 5, counterBuffer);
+
+    setGrid(INTEGRATE);
+    const GLint* u = locations[INTEGRATE];
+    gl->uniform1f(u[DT], dt);
+    gl->uniform1f(u[GRAVITY], config.gravity);
+    gl->uniform1i(u[DRAG_MODEL], (GLint)config.dragModel);
+    gl->uniform1f(u[DRAG], config.drag);
+    gl->uniform1i(u[WALLS], (GLint)config.walls);
+    gl->uniform1f(u[RESTITUTION], config.restitution);
+    gl->uniform4f(u[BOX], bounds.left, bounds.top, bounds.left + bounds.width, bounds.top + bounds.height);
+    gl->dispatchCompute(groups(count), 1, 1);
+    gl->memoryBarrier(gl43::SHADER_STORAGE_BARRIER_BIT);
+
+    setGrid(SCAN);
+    gl->uniform1i(locations[SCAN][CELLS], cells);
+    gl->dispatchCompute(1, 1, 1);
+    gl->memoryBarrier(gl43::SHADER_STORAGE_BARRIER_BIT);
+
+    setGrid(SCATTER);
+    gl->dispatchCompute(groups(count), 1, 1);
+    gl->memoryBarrier(gl43::SHADER_STORAGE_BARRIER_BIT);
+
+    // Passes ping-pong between the two copies over the same grid; the
+    // solved copy is live after each, and no data moves
+    setGrid(SOLVE);
+    gl->uniform1f(locations[SOLVE][RESTITUTION], config.restitution);
+    for (int pass = 0; pass < SOLVER_PASSES; ++pass) {
+        gl->uniform1i(locations[SOLVE][COUNT_PAIRS], pass == 0);
+        gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 0, state[current]);
+        gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 1, state[1 - current]);
+        gl->dispatchCompute(groups(count), 1, 1);
+        gl->memoryBarrier(gl43::SHADER_STORAGE_BARRIER_BIT);
+        current = 1 - current;
+    }
+    gl->useProgram(0);
+    context.setActive(false);
+}
+
+bool GpuCollisionWorld::draw(CircleBatch& batch, float alpha, sf::Color color) {
+    if (!ready() || !context.setActive(true)) return false;
+    if (!batch.resizeOnGpu(count)) {
+        context.setActive(false);
+        return false;
+    }
+    if (count > 0) {
+        gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 0, state[current]);
+        gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 6, batch.nativeBuffer());
+        setGrid(DRAW);
+        gl->uniform1f(locations[DRAW][ALPHA], alpha);
+        // sf::Color's bytes in memory order, as sf::Vertex holds them
+        gl->uniform1ui(locations[DRAW][COLOR], GLuint(color.r) | GLuint(color.g) << 8
+            | GLuint(color.b) << 16 | GLuint(color.a) << 24);
+        gl->uniform1f(locations[DRAW][TEXTURE_SIZE], float(CircleBatch::DISC_SIZE));
+        gl->dispatchCompute(groups(count), 1, 1);
+        gl->memoryBarrier(gl43::VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+        gl->useProgram(0);
+    }
+    // Finished before the render thread's context draws it
+    gl->finish();
+    context.setActive(false);
+    return true;
+}
+
+GpuCollisionWorld::Counters GpuCollisionWorld::counters() {
+    Counters c;
+    if (!ready() || !context.setActive(true)) return c;
+    GLuint values[3] = {};
+    gl->memoryBarrier(gl43::BUFFER_UPDATE_BARRIER_BIT);
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, counterBuffer);
+    gl->getBufferSubData(gl43::SHADER_STORAGE_BUFFER, 0, sizeof values, values);
+    context.setActive(false);
+    c.contacts = values[0];
+    c.candidates = values[1];
+    c.contactTotal = values[2];
+    return c;
+}
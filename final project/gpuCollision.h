@@ -0,0 +1,98 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "particleStore.h"
+#include "sceneConfig.h"
+
+namespace gl43 { struct Api; }
+class CircleBatch;
+
+// The container-collision step as OpenGL 4.3 compute shaders, with the balls
+// resident on the GPU. Each step is one dispatch per stage: integrate and
+// walls, a uniform-grid broadphase built by counting sort (count, scan,
+// scatter), then contacts. The batched renderer draws straight from it:
+// draw() writes the quads into a CircleBatch's vertex buffer on the GPU.
+// The balls cross the bus only in upload() and download(), for edits such
+// as spawning or throwing one, and for reports.
+//
+// It differs from CollisionWorld in what the shaders do not implement: the
+// integrator is always semi-implicit Euler (see supports()), nothing
+// sleeps, and there is no CCD. Contacts are solved in Jacobi passes, every
+// ball averaging its neighbours' impulses at once, where the CPU solves them
+// in sequence, so piles hold more, shallower overlaps. The order balls land in a
+// cell varies, so runs are not reproducible bit for bit.
+//
+// Like GpuNBodyForces it owns a GL context, current only inside its calls,
+// and is used from one thread at a time.
+class GpuCollisionWorld {
+public:
+    GpuCollisionWorld();
+    ~GpuCollisionWorld();
+
+    GpuCollisionWorld(const GpuCollisionWorld&) = delete;
+    GpuCollisionWorld& operator=(const GpuCollisionWorld&) = delete;
+
+    // False when the driver has no GL 4.3 or a shader failed to build;
+    // error() says which.
+    bool ready() const { return programs[0] != 0; }
+    const std::string& error() const { return failure; }
+    // False for a config the shaders cannot run: any integrator but
+    // semi-implicit Euler.
+    static bool supports(const SceneConfig& config);
+
+    sf::FloatRect bounds;
+    SceneConfig config;
+
+    // Replaces the GPU state with the balls' positions, velocities, radii
+    // and inverse masses.
+    void upload(const ParticleStore& balls);
+    // Copies the GPU state, previous positions included, back into balls,
+    // which must hold as many as were uploaded.
+    void download(ParticleStore& balls);
+    void step(float dt);
+    // Writes every ball, blended alpha of the way from its previous to its
+    // current position, into batch as a quad of the given colour. Waits for
+    // the GPU, so a context on another thread can draw the batch right
+    // after. False where the batch has no vertex buffer.
+    bool draw(CircleBatch& batch, float alpha, sf::Color color);
+
+    std::size_t size() const { return count; }
+
+    struct Counters {
+        std::uint32_t contacts = 0;     // touching pairs, last step
+        std::uint32_t candidates = 0;   // pairs whose boxes overlap, last step
+        std::uint32_t contactTotal = 0; // touching pairs over every step; wraps at 2^32
+    };
+    // Reads the counters back, waiting for the GPU.
+    Counters counters();
+
+private:
+    enum Program { INTEGRATE, SCAN, SCATTER, SOLVE, DRAW, PROGRAMS };
+    enum Uniform {
+        COUNT, GRID_ORIGIN, INV_CELL, COLS, ROWS, CELLS, DT, GRAVITY, DRAG_MODEL, DRAG,
+        WALLS, RESTITUTION, BOX, ALPHA, COLOR, TEXTURE_SIZE, COUNT_PAIRS, UNIFORMS
+    };
+
+    void reserveBalls(std::size_t balls);
+    void reserveCells(int cells);
+    void setGrid(Program p);
+
+    sf::Context context;
+    std::string failure;
+    const gl43::Api* gl = nullptr;
+    unsigned programs[PROGRAMS] = {};
+    int locations[PROGRAMS][UNIFORMS] = {};
+    unsigned state[2] = {};     // ping-pong copies of the balls; state[current] is live
+    int current = 0;
+    unsigned cellCount = 0, cellStart = 0, sorted = 0, counterBuffer = 0;
+
+    std::size_t count = 0, ballCapacity = 0;
+    int cellCapacity = 0;
+    float maxRadius = 0.f;      // of the uploaded balls; sets the cell size
+    float cellSize = 1.f;
+    int cols = 1, rows = 1;
+    std::vector<float> staging; // one Ball per body, as the shaders lay it out
+};
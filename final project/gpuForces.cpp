@@ -0,0 +1,111 @@
+#include "gpuForces.h"
+#include "glCompute.h"
+
+namespace {
+    constexpr int GROUP_SIZE = 256; // invocations per work group, and bodies per tile
+
+    const char* const FORCES_SHADER = R"(
+        #version 430
+        layout(local_size_x = 256) in;
+        layout(std430, binding = 0) readonly buffer Bodies { vec4 body[]; }; // x, y, mass, 0
+        layout(std430, binding = 1) writeonly buffer Accel { vec2 accel[]; };
+        uniform int count;
+        uniform float eps2;
+        shared vec4 tile[256];
+
+        void main() {
+            uint i = gl_GlobalInvocationID.x;
+            vec2 p = i < uint(count) ? body[i].xy : vec2(0.0);
+            vec2 a = vec2(0.0);
+            for (int start = 0; start < count; start += 256) {
+                int j = start + int(gl_LocalInvocationID.x);
+                tile[gl_LocalInvocationID.x] = j < count ? body[j] : vec4(0.0);
+                barrier();
+                int n = min(256, count - start);
+                for (int k = 0; k < n; ++k) {
+                    vec2 d = tile[k].xy - p;
+                    float r2 = dot(d, d) + eps2;
+                    // The body itself is not skipped but adds nothing: its d is 0.
+                    // The guard only keeps r2 = 0 (no softening) from dividing by zero
+                    float inv = r2 > 0.0 ? inversesqrt(r2) : 0.0;
+                    a += d * (tile[k].z * inv * inv * inv);
+                }
+                barrier();
+            }
+            if (i < uint(count)) accel[i] = a;
+        }
+    )";
+}
+
+GpuNBodyForces::GpuNBodyForces()
+    : context(sf::ContextSettings(0, 0, 0, 4, 3), 1, 1)
+{
+    gl = gl43::load(context, failure);
+    if (gl) program = gl43::buildProgram(*gl, FORCES_SHADER, "forces", failure);
+    if (!program) {
+        context.setActive(false);
+        return;
+    }
+    countLocation = gl->getUniformLocation(program, "count");
+    eps2Location = gl->getUniformLocation(program, "eps2");
+    gl->genBuffers(1, &bodyBuffer);
+    gl->genBuffers(1, &accelBuffer);
+    context.setActive(false);
+}
+
+GpuNBodyForces::~GpuNBodyForces() {
+    if (!ready()) return;
+    context.setActive(true);
+    gl->deleteBuffers(1, &bodyBuffer);
+    gl->deleteBuffers(1, &accelBuffer);
+    gl->deleteProgram(program);
+    context.setActive(false);
+}
+
+void GpuNBodyForces::reserve(int count) {
+    if (count <= capacity) return;
+    // Grow by half again, so a growing system reallocates rarely
+    capacity = count + count / 2;
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, bodyBuffer);
+    gl->bufferData(gl43::SHADER_STORAGE_BUFFER, gl43::Sizeiptr(capacity) * 4 * sizeof(float), nullptr, gl43::DYNAMIC_DRAW);
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, accelBuffer);
+    gl->bufferData(gl43::SHADER_STORAGE_BUFFER, gl43::Sizeiptr(capacity) * 2 * sizeof(float), nullptr, gl43::DYNAMIC_DRAW);
+    upload.resize(std::size_t(capacity) * 4);
+    readback.resize(std::size_t(capacity) * 2);
+}
+
+bool GpuNBodyForces::compute(const float* x, const float* y, const float* mass, int count, float eps2,
+    float* ax, float* ay) {
+    if (!ready()) return false;
+    if (count <= 0) return true;
+    if (!context.setActive(true)) return false;
+    reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        upload[4 * i] = x[i];
+        upload[4 * i + 1] = y[i];
+        upload[4 * i + 2] = mass[i];
+        upload[4 * i + 3] = 0.f;
+    }
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, bodyBuffer);
+    gl->bufferSubData(gl43::SHADER_STORAGE_BUFFER, 0, gl43::Sizeiptr(count) * 4 * sizeof(float), upload.data());
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 0, bodyBuffer);
+    gl->bindBufferBase(gl43::SHADER_STORAGE_BUFFER, 1, accelBuffer);
+
+    gl->useProgram(program);
+    gl->uniform1i(countLocation, count);
+    gl->uniform1f(eps2Location, eps2);
+    gl->dispatchCompute(GLuint((count + GROUP_SIZE - 1) / GROUP_SIZE), 1, 1);
+    // Reading back waits for the dispatch to finish
+    gl->memoryBarrier(gl43::BUFFER_UPDATE_BARRIER_BIT);
+    gl->bindBuffer(gl43::SHADER_STORAGE_BUFFER, accelBuffer);
+    gl->getBufferSubData(gl43::SHADER_STORAGE_BUFFER, 0, gl43::Sizeiptr(count) * 2 * sizeof(float), readback.data());
+    gl->useProgram(0);
+    context.setActive(false);
+
+    for (int i = 0; i < count; ++i) {
+        ax[i] = readback[2 * i];
+        ay[i] = readback[2 * i + 1];
+    }
+    return true;
+}
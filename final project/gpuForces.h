@@ -0,0 +1,50 @@
+#pragma once
+#include <SFML/Window.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gl43 { struct Api; }
+
+// Exact pairwise gravity on the GPU: an OpenGL 4.3 compute shader sums every
+// body against every other, in tiles staged through shared memory. It is
+// O(n^2) with no opening-angle error; the benchmark's nbody_direct scene is
+// the same sum on the CPU, for a like-for-like comparison.
+//
+// It owns a GL context of its own and makes it current only while
+// computing, so it works in headless runs and on a simulation thread, from
+// one thread at a time. Only the forces run here: NBodyWorld integrates in
+// double on the CPU, so the float positions it narrows for the forces go up
+// and the accelerations come back on every call. The collision path
+// (gpuCollision.h) is the one whose state stays on the GPU.
+class GpuNBodyForces {
+public:
+    GpuNBodyForces();
+    ~GpuNBodyForces();
+
+    GpuNBodyForces(const GpuNBodyForces&) = delete;
+    GpuNBodyForces& operator=(const GpuNBodyForces&) = delete;
+
+    // False when the driver has no GL 4.3 or the kernel failed to build;
+    // error() says which.
+    bool ready() const { return program != 0; }
+    const std::string& error() const { return failure; }
+
+    // a_i = sum over j != i of m_j d / (|d|^2 + eps2)^1.5, d = p_j - p_i.
+    // False, leaving ax/ay alone, when not ready.
+    bool compute(const float* x, const float* y, const float* mass, int count, float eps2,
+        float* ax, float* ay);
+
+private:
+    void reserve(int count);
+
+    sf::Context context;
+    std::string failure;
+    const gl43::Api* gl = nullptr;
+    unsigned program = 0;
+    unsigned bodyBuffer = 0, accelBuffer = 0;
+    int countLocation = -1, eps2Location = -1;
+    int capacity = 0;              // bodies the buffers hold
+    std::vector<float> upload;     // x, y, mass, 0 per body
+    std::vector<float> readback;   // ax, ay per body
+};
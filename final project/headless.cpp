@@ -0,0 +1,922 @@
+#include "headless.h"
+#include <SFML/System.hpp>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "kollision.h"
+#include "viscosity.h"
+#include "projectile.h"
+#include "solarSystem.h"
+#include "nbody.h"
+#include "gpuCollision.h"
+#include "gpuForces.h"
+#include "heapCounter.h"
+#include "jobSystem.h"
+#include "profiler.h"
+#include "simdKernels.h"
+#include "replay.h"
+#include "sceneConfig.h"
+#include "telemetry.h"
+
+namespace {
+    // Largest N-body system whose energy each telemetry sample measures
+    constexpr std::size_t TELEMETRY_ENERGY_BODIES = 5000;
+
+    void printUsage() {
+        std::cerr <<
+            "usage: --headless <orbit|nbody|projectile|shells|collision|viscosity|columns>\n"
+            "       [--steps N] [--dt seconds] [--count N] [--seed N] [--threads N]\n"
+            "       [--out state.csv] [--profile prefix] [--fluids table.csv] [--config scene.cfg] [--record run.rec]\n"
+            "       [--telemetry udp:host:port|tcp:host:port] [--telemetry-hz N]\n"
+            "       [--param key=value]...\n"
+            "       [--sweep key=v1,v2,...|key=first:last:count]... [--jobs N]\n";
+    }
+
+    // "key=v1,v2,..." or "key=first:last:count" (count evenly spaced values)
+    SweepAxis parseSweepAxis(const std::string& value) {
+        const auto eq = value.find('=');
+        if (eq == std::string::npos || eq == 0) throw std::invalid_argument(value);
+        SweepAxis axis;
+        axis.key = value.substr(0, eq);
+        const std::string list = value.substr(eq + 1);
+        const auto colon = list.find(':');
+        if (colon != std::string::npos) {
+            const auto second = list.find(':', colon + 1);
+            if (second == std::string::npos) throw std::invalid_argument(value);
+            const double first = std::stod(list.substr(0, colon));
+            const double last = std::stod(list.substr(colon + 1, second - colon - 1));
+            const int count = std::stoi(list.substr(second + 1));
+            if (count < 1) throw std::invalid_argument(value);
+            for (int i = 0; i < count; ++i)
+                axis.values.push_back(count == 1 ? first : first + (last - first) * i / (count - 1));
+        }
+        else {
+            std::istringstream items(list);
+            std::string item;
+            while (std::getline(items, item, ','))
+                axis.values.push_back(std::stod(item));
+        }
+        if (axis.values.empty()) throw std::invalid_argument(value);
+        return axis;
+    }
+
+    // The options a sweep may set besides scene parameters; all but dt are
+    // whole numbers
+    bool isSweepOption(const std::string& key) {
+        return key == "seed" || key == "count" || key == "steps" || key == "dt";
+    }
+    bool isWholeNumberKey(const std::string& key) { return isSweepOption(key) && key != "dt"; }
+
+    // The --param keys each mode reads, so that a misspelt one is an error
+    // rather than a run with the default. Keep in step with the runners.
+    bool modeReadsParam(const std::string& mode, const std::string& key) {
+        static const std::map<std::string, std::vector<std::string>> keys = {
+            { "collision", { "restitution", "integrator", "drag_model", "drag", "gravity", "walls",
+                "brute", "ccd", "sleep", "radius", "speed", "gpu" } },
+            { "viscosity", { "viscosity" } },
+            { "columns", { "width", "height", "radius" } },
+            { "projectile", { "angle", "speed" } },
+            { "shells", { "drag_model", "drag", "min_angle", "max_angle", "min_speed", "max_speed" } },
+            { "orbit", {} },
+            { "nbody", { "theta", "softening", "integrator", "gpu", "direct" } },
+        };
+        if (key == "simd") return true; // every mode
+        const auto it = keys.find(mode);
+        return it != keys.end() && std::find(it->second.begin(), it->second.end(), key) != it->second.end();
+    }
+
+    // What a run reports: key=value lines for the terminal, the same
+    // fields kept in order for a sweep's results table, and live samples
+    // while it steps when telemetry is on.
+    class RunReport {
+    public:
+        using Field = std::pair<std::string, std::string>;
+
+        RunReport(std::ostream& output, Telemetry& live) : telemetry(live), stream(output) {}
+
+        // Call after every step; fill(TelemetrySample&) runs only when a
+        // sample is due, so it may measure something costly.
+        template <typename Fill>
+        void afterStep(Fill&& fill) {
+            if (!telemetry.afterStep()) return;
+            fill(telemetry.next());
+            telemetry.publish();
+        }
+        // A last sample with the final state
+        template <typename Fill>
+        void finish(Fill&& fill) {
+            if (!telemetry.active()) return;
+            fill(telemetry.next());
+            telemetry.publish();
+        }
+
+        // Free-form output, e.g. the columns table
+        std::ostream& out() { return stream; }
+        // Starts a line with a bare label; its fields are kept as label_key
+        void beginLine(const std::string& label) {
+            line = label;
+            prefix = label + "_";
+        }
+        template <typename T>
+        void add(const std::string& key, const T& value) {
+            const std::string text = format(value);
+            if (!line.empty()) line += ' ';
+            line += key + '=' + text;
+            fields.emplace_back(prefix + key, text);
+        }
+        void endLine() {
+            stream << line << "\n";
+            line.clear();
+            prefix.clear();
+        }
+        // A field for the table only, not printed
+        template <typename T>
+        void record(const std::string& key, const T& value) { fields.emplace_back(prefix + key, format(value)); }
+
+        std::vector<Field> fields;
+
+    private:
+        template <typename T>
+        static std::string format(const T& value) {
+            std::ostringstream s;
+            s << value;
+            return s.str();
+        }
+
+        Telemetry& telemetry;
+        std::ostream& stream;
+        std::string line, prefix;
+    };
+
+    // Wall time of a stepping loop, and the heap allocations of its second
+    // half, by which time every scratch buffer has reached its working size.
+    // A sequential run counts only its own thread's allocations, so runs
+    // sharing the process in a sweep do not count each other's.
+    class RunTimer {
+    public:
+        explicit RunTimer(const HeadlessOptions& opts)
+            : halfway(opts.steps / 2), ownThreadOnly(opts.threads == 0) {}
+        // Call before running step s
+        void beforeStep(int s) {
+            if (s != halfway) return;
+            allocationsAtHalf = allocations();
+            stepsAtHalf = s;
+        }
+        sf::Time elapsed() const { return clock.getElapsedTime(); }
+        // Per step over the second half, or the whole run if it stopped early
+        double allocationsPerStep(int stepsRun) const {
+            const int steps = stepsRun - stepsAtHalf;
+            return steps > 0 ? double(allocations() - allocationsAtHalf) / steps : 0.0;
+        }
+
+    private:
+        std::uint64_t allocations() const { return ownThreadOnly ? threadHeapAllocations() : heapAllocations(); }
+
+        int halfway;
+        bool ownThreadOnly;
+        int stepsAtHalf = 0;
+        std::uint64_t allocationsAtHalf = allocations();
+        sf::Clock clock;
+    };
+
+    void printTiming(RunReport& report, const HeadlessOptions& opts, std::size_t bodies, const RunTimer& timer, int stepsRun) {
+        const double us = static_cast<double>(timer.elapsed().asMicroseconds());
+        // Shells and projectiles stop early once everything has landed
+        const double steps = std::max(stepsRun, 1);
+        // Read before the report's own formatting allocates
+        const double allocationsPerStep = timer.allocationsPerStep(stepsRun);
+        report.add("mode", opts.mode);
+        report.add("steps", stepsRun);
+        report.add("dt", opts.dt);
+        report.add("bodies", bodies);
+        report.add("seed", opts.seed);
+        report.add("threads", opts.threads);
+        report.add("simd", simdKernels().name);
+        report.add("wall_ms", us / 1000.0);
+        report.add("us_per_step", us / steps);
+        report.add("ns_per_body_step", bodies ? us * 1000.0 / (steps * bodies) : 0.0);
+        report.add("heap_allocs_per_step", allocationsPerStep);
+        report.endLine();
+    }
+
+    void dumpParticles(const HeadlessOptions& opts, const ParticleStore& p) {
+        if (opts.outFile.empty()) return;
+        std::ofstream out(opts.outFile);
+        if (!out) {
+            std::cerr << "Failed to open " << opts.outFile << "\n";
+            return;
+        }
+        out << "i,x,y,vx,vy\n";
+        for (std::size_t i = 0; i < p.size(); ++i)
+            out << i << ',' << p.x[i] << ',' << p.y[i] << ',' << p.vx[i] << ',' << p.vy[i] << '\n';
+    }
+
+    // Opens opts.recordFile when given; false only if that fails.
+    bool startRecording(const HeadlessOptions& opts, ReplayRecorder& recorder, const ParticleStore& p,
+        sf::FloatRect bounds) {
+        if (opts.recordFile.empty()) return true;
+        return recorder.open(opts.recordFile, p, opts.dt, opts.seed, bounds);
+    }
+
+    void finishRecording(RunReport& report, const HeadlessOptions& opts, ReplayRecorder& recorder) {
+        if (!recorder.isOpen()) return;
+        const std::size_t frames = recorder.frameCount();
+        const std::size_t bytes = recorder.bytesWritten();
+        if (recorder.close())
+            report.out() << "recorded " << frames << " frames, " << bytes << " bytes to " << opts.recordFile << "\n";
+        else
+            std::cerr << "Failed to finish " << opts.recordFile << "\n";
+    }
+
+    // A scene's physics from --config, then from any --param naming a
+    // SceneConfig key
+    // One --param through SceneConfig's range check; false, with a message,
+    // for a value it rejects. Absent keys keep the config's value.
+    bool configParam(const HeadlessOptions& opts, const std::string& key, SceneConfig& config) {
+        const auto it = opts.params.find(key);
+        if (it == opts.params.end() || config.set(key, it->second)) return true;
+        std::cerr << "Bad value " << it->second << " for " << key << "\n";
+        return false;
+    }
+
+    bool loadConfig(const HeadlessOptions& opts, SceneConfig& config) {
+        if (!opts.configFile.empty() && !loadSceneConfig(opts.configFile, config)) return false;
+        for (const auto& p : opts.params) {
+            if (SceneConfig::isKey(p.first) && !configParam(opts, p.first, config)) return false;
+        }
+        return true;
+    }
+
+    double kineticEnergy(const ParticleStore& p) {
+        double e = 0.0;
+        for (std::size_t i = 0; i < p.size(); ++i) {
+            if (p.invMass[i] > 0.f)
+                e += 0.5 * (p.vx[i] * p.vx[i] + p.vy[i] * p.vy[i]) / p.invMass[i];
+        }
+        return e;
+    }
+
+    // gpu=1: the scene stepped by the compute shaders (gpuCollision.h). The
+    // balls stay on the GPU, so only telemetry samples and the end of the
+    // run read them back; the shaders have no CCD, sleeping or brute force.
+    int runCollisionGpu(const HeadlessOptions& opts, RunReport& report, CollisionWorld& world) {
+        for (const char* key : { "brute", "ccd", "sleep" }) {
+            if (opts.param(key, 0.f) == 0.f) continue;
+            std::cerr << "gpu=1 has no " << key << "; pass " << key << "=0\n";
+            return 1;
+        }
+        if (!GpuCollisionWorld::supports(world.config)) {
+            std::cerr << "gpu=1 needs integrator=0 (" << integratorName(IntegratorKind::SemiImplicitEuler) << ")\n";
+            return 1;
+        }
+        if (!opts.recordFile.empty()) {
+            std::cerr << "gpu=1 cannot record: the balls stay on the GPU\n";
+            return 1;
+        }
+        GpuCollisionWorld gpu;
+        if (!gpu.ready()) {
+            std::cerr << "GPU collision unavailable: " << gpu.error() << "\n";
+            return 1;
+        }
+        gpu.bounds = world.bounds;
+        gpu.config = world.config;
+        gpu.upload(world.balls);
+
+        const double e0 = kineticEnergy(world.balls);
+        auto sample = [&](TelemetrySample& t) {
+            gpu.download(world.balls);
+            t.bodies = world.balls.size();
+            t.contacts = gpu.counters().contacts;
+            t.energy = kineticEnergy(world.balls);
+            if (e0 != 0.0) t.energyDrift = (t.energy - e0) / e0;
+        };
+        RunTimer timer(opts);
+        for (int s = 0; s < opts.steps; ++s) {
+            timer.beforeStep(s);
+            profiler().beginFrame();
+            ProfileZone zone("GPU step");
+            gpu.step(opts.dt);
+            report.afterStep(sample);
+        }
+        // Waits for the queued steps, so the wall time covers them
+        const GpuCollisionWorld::Counters counters = gpu.counters();
+        report.finish(sample);
+        printTiming(report, opts, world.balls.size(), timer, opts.steps);
+        gpu.download(world.balls);
+        report.add("kinetic_energy", kineticEnergy(world.balls));
+        report.add("contacts_per_step", opts.steps ? double(counters.contactTotal) / opts.steps : 0.0);
+        report.add("candidates_last_step", counters.candidates);
+        report.add("solver", "gpu");
+        report.endLine();
+        dumpParticles(opts, world.balls);
+        return 0;
+    }
+
+    int runCollision(const HeadlessOptions& opts, RunReport& report) {
+        // Same container as the interactive 800x600 window
+        CollisionWorld world;
+        world.bounds = sf::FloatRect(50.f, 50.f, 700.f, 500.f);
+        if (!loadConfig(opts, world.config)) return 1;
+        if (opts.param("brute", 0.f) != 0.f) world.broadphase = BroadphaseMode::BruteForce;
+        world.ccd = opts.param("ccd", 1.f) != 0.f;
+        world.allowSleep = opts.param("sleep", 1.f) != 0.f;
+        std::unique_ptr<JobSystem> pool;
+        if (opts.threads > 0) {
+            pool = std::make_unique<JobSystem>(opts.threads);
+            world.pool = pool.get();
+        }
+
+        const int count = opts.count > 0 ? opts.count : 10;
+        const float radius = opts.param("radius", opts.count > 0 ? 4.f : 15.f);
+        const float speed = opts.param("speed", 200.f);
+        std::mt19937 rng{ opts.seed };
+        world.spawn(count, radius, radius, rng);
+        // Headless scenes start moving; the interactive one waits for a throw
+        std::uniform_real_distribution<float> uv(-speed, speed);
+        for (int i = 0; i < count; ++i) {
+            world.balls.vx[i] = uv(rng);
+            world.balls.vy[i] = uv(rng);
+        }
+        if (opts.param("gpu", 0.f) != 0.f) return runCollisionGpu(opts, report, world);
+
+        ReplayRecorder recorder;
+        if (!startRecording(opts, recorder, world.balls, world.bounds)) return 1;
+        const double e0 = kineticEnergy(world.balls);
+        auto sample = [&](TelemetrySample& t) {
+            t.bodies = world.balls.size();
+            t.contacts = world.contacts;
+            t.sleeping = world.sleep.sleepingCount();
+            t.energy = kineticEnergy(world.balls);
+            if (e0 != 0.0) t.energyDrift = (t.energy - e0) / e0;
+        };
+        std::size_t contacts = 0, ccdHits = 0;
+        RunTimer timer(opts);
+        for (int s = 0; s < opts.steps; ++s) {
+            timer.beforeStep(s);
+            profiler().beginFrame();
+            world.step(opts.dt);
+            contacts += world.contacts;
+            ccdHits += world.ccdHits;
+            if (recorder.isOpen()) recorder.record(world.balls);
+            report.afterStep(sample);
+        }
+        report.finish(sample);
+        printTiming(report, opts, world.balls.size(), timer, opts.steps);
+        report.add("kinetic_energy", kineticEnergy(world.balls));
+        report.add("contacts_per_step", opts.steps ? double(contacts) / opts.steps : 0.0);
+        report.add("candidates_last_step", world.bpStats.candidatePairs);
+        report.add("colours_last_step", world.colours);
+        report.add("ccd_hits", ccdHits);
+        report.add("sleeping", world.sleep.sleepingCount());
+        report.endLine();
+        finishRecording(report, opts, recorder);
+        dumpParticles(opts, world.balls);
+        return 0;
+    }
+
+    // The --fluids table, or the built-in one when none is given
+    bool fluidTable(const HeadlessOptions& opts, std::vector<Fluid>& fluids) {
+        if (opts.fluidFile.empty()) {
+            fluids = defaultFluids();
+            return true;
+        }
+        if (loadFluids(opts.fluidFile, fluids)) return true;
+        std::cerr << "Failed to load fluids from " << opts.fluidFile << "\n";
+        return false;
+    }
+
+    int runViscosity(const HeadlessOptions& opts, RunReport& report) {
+        // One ball per column, cycling through the fluid table
+        std::vector<Fluid> fluids;
+        if (!fluidTable(opts, fluids)) return 1;
+        const int count = opts.count > 0 ? opts.count : (int)fluids.size();
+        const float width = 150.f, height = 400.f, spacing = 100.f, topY = 100.f;
+        ViscosityWorld world;
+        for (int i = 0; i < count; ++i) {
+            float drag = opts.param("viscosity", fluids[i % fluids.size()].viscosity);
+            float cx = i * (width + spacing) + width / 2.f;
+            world.addBall(cx, topY + height / 2.f - 10.f, 10.f, drag, topY + height);
+        }
+
+        auto sample = [&](TelemetrySample& t) {
+            t.bodies = world.balls.size();
+            t.sleeping = world.sleep.sleepingCount();
+        };
+        RunTimer timer(opts);
+        for (int s = 0; s < opts.steps; ++s) {
+            timer.beforeStep(s);
+            profiler().beginFrame();
+            ProfileZone zone("Physics");
+            world.step(opts.dt);
+            report.afterStep(sample);
+        }
+        report.finish(sample);
+        printTiming(report, opts, world.balls.size(), timer, opts.steps);
+
+        report.add("settled", std::to_string(world.sleep.sleepingCount()) + "/" + std::to_string(count));
+        report.endLine();
+        dumpParticles(opts, world.balls);
+        return 0;
+    }
+
+    int runShells(const HeadlessOptions& opts, RunReport& report) {
+        // Ballistics sweep: --count shells over an angle x speed grid, run until all land
+        ShellBatch batch;
+        batch.origin = { 50.f, 586.f };
+        batch.groundY = 592.f;
+        std::unique_ptr<JobSystem> pool;
+        if (opts.threads > 0) {
+            pool = std::make_unique<JobSystem>(opts.threads);
+            batch.pool = pool.get();
+        }
+        // drag_model: 0 vacuum, 1 linear, 2 quadratic
+        SceneConfig config;
+        if (!configParam(opts, "drag_model", config)) return 1;
+        batch.dragModel = config.dragModel;
+        if (batch.dragModel != DragModel::None) {
+            config.drag = batch.dragModel == DragModel::Quadratic ? 0.001f : 0.5f;
+            if (!configParam(opts, "drag", config)) return 1;
+            batch.drag = config.drag;
+        }
+        const int count = opts.count > 0 ? opts.count : 10000;
+        batch.launchSweep(count, opts.param("min_angle", 5.f), opts.param("max_angle", 85.f),
+            opts.param("min_speed", 200.f), opts.param("max_speed", 1000.f));
+
+        auto sample = [&](TelemetrySample& t) { t.bodies = batch.shells.size() - batch.landedCount; };
+        int steps = 0;
+        RunTimer timer(opts);
+        while (steps < opts.steps && !batch.done()) {
+            timer.beforeStep(steps);
+            profiler().beginFrame();
+            ProfileZone zone("Physics");
+            batch.step(opts.dt);
+            ++steps;
+            report.afterStep(sample);
+        }
+        report.finish(sample);
+        printTiming(report, opts, batch.shells.size(), timer, steps);
+        const ShellBatch::Stats st = batch.stats();
+        report.add("model", dragModelName(batch.dragModel));
+        report.add("drag", batch.drag);
+        report.add("landed", std::to_string(batch.landedCount) + "/" + std::to_string(count));
+        report.add("steps_run", steps);
+        report.add("range_min", st.minRange);
+        report.add("range_mean", st.meanRange);
+        report.add("range_max", st.maxRange);
+        report.add("height_min", st.minHeight);
+        report.add("height_mean", st.meanHeight);
+        report.add("height_max", st.maxHeight);
+        report.add("flight_time", batch.time);
+        report.add("best_angle", st.bestAngle);
+        report.add("best_speed", st.bestSpeed);
+        report.add("max_range_error", st.maxRangeError);
+        report.endLine();
+
+        if (!opts.outFile.empty()) {
+            std::ofstream out(opts.outFile);
+            if (!out) {
+                std::cerr << "Failed to open " << opts.outFile << "\n";
+                return 0;
+            }
+            out << "i,angle,speed,landed,range,max_height,flight_time\n";
+            for (int i = 0; i < count; ++i)
+                out << i << ',' << batch.angle[i] << ',' << batch.speed[i] << ',' << (int)batch.landed[i]
+                    << ',' << batch.range[i] << ',' << batch.maxHeight[i] << ',' << batch.flightTime[i] << '\n';
+        }
+        return 0;
+    }
+
+    int runColumns(const HeadlessOptions& opts, RunReport& report) {
+        // --count balls in every fluid column, for drag parameter studies
+        std::vector<Fluid> fluids;
+        if (!fluidTable(opts, fluids)) return 1;
+        const float width = opts.param("width", 150.f), height = opts.param("height", 400.f);
+        std::vector<sf::FloatRect> rects;
+        for (std::size_t c = 0; c < fluids.size(); ++c)
+            rects.emplace_back(c * (width + 100.f), 0.f, width, height);
+
+        ViscosityColumns columns;
+        std::unique_ptr<JobSystem> pool;
+        if (opts.threads > 0) {
+            pool = std::make_unique<JobSystem>(opts.threads);
+            columns.pool = pool.get();
+        }
+        const int perColumn = opts.count > 0 ? opts.count : 1000;
+        columns.build(fluids, rects, perColumn, opts.param("radius", 2.f), opts.seed);
+
+        auto sample = [&](TelemetrySample& t) {
+            t.bodies = columns.bodyCount();
+            t.sleeping = columns.sleepingCount();
+            t.contacts = 0;
+            for (const CollisionWorld& w : columns.columns) t.contacts += w.contacts;
+        };
+        RunTimer timer(opts);
+        for (int s = 0; s < opts.steps; ++s) {
+            timer.beforeStep(s);
+            profiler().beginFrame();
+            columns.step(opts.dt);
+            report.afterStep(sample);
+        }
+        report.finish(sample);
+        printTiming(report, opts, columns.bodyCount(), timer, opts.steps);
+
+        report.out() << "column,fluid,viscosity,mean_fall_speed,stokes_speed,sleeping\n";
+        for (std::size_t c = 0; c < columns.columns.size(); ++c) {
+            const std::string n = std::to_string(c);
+            report.out() << c << ',' << fluids[c].name << ',' << fluids[c].viscosity << ','
+                << columns.meanFallSpeed((int)c) << ',' << columns.stokesTerminalSpeed((int)c) << ','
+                << columns.columns[c].sleep.sleepingCount() << "\n";
+            report.record("mean_fall_speed_" + n, columns.meanFallSpeed((int)c));
+            report.record("stokes_speed_" + n, columns.stokesTerminalSpeed((int)c));
+            report.record("sleeping_" + n, columns.columns[c].sleep.sleepingCount());
+        }
+
+        if (!opts.outFile.empty()) {
+            std::ofstream out(opts.outFile);
+            if (!out) {
+                std::cerr << "Failed to open " << opts.outFile << "\n";
+                return 0;
+            }
+            out << "column,i,x,y,vx,vy\n";
+            for (std::size_t c = 0; c < columns.columns.size(); ++c) {
+                const ParticleStore& p = columns.columns[c].balls;
+                for (std::size_t i = 0; i < p.size(); ++i)
+                    out << c << ',' << i << ',' << p.x[i] << ',' << p.y[i] << ',' << p.vx[i] << ',' << p.vy[i] << '\n';
+            }
+        }
+        return 0;
+    }
+
+    int runProjectile(const HeadlessOptions& opts, RunReport& report) {
+        const float angle = opts.param("angle", 45.f) * DEG_TO_RAD;
+        const float speed = opts.param("speed", 600.f);
+        ProjectileWorld shell;
+        shell.origin = { 50.f, 586.f };
+        shell.groundY = 592.f;
+        shell.reset();
+        shell.launch(shell.origin, { speed * std::cos(angle), -speed * std::sin(angle) });
+
+        int steps = 0;
+        RunTimer timer(opts);
+        while (steps < opts.steps && !shell.landed) {
+            timer.beforeStep(steps);
+            profiler().beginFrame();
+            ProfileZone zone("Physics");
+            shell.step(opts.dt);
+            ++steps;
+        }
+        printTiming(report, opts, 1, timer, steps);
+        report.add("landed", shell.landed);
+        report.add("steps_run", steps);
+        report.add("flight_time", steps * opts.dt);
+        report.add("range", shell.range);
+        report.add("max_height", shell.maxHeight);
+        report.endLine();
+        return 0;
+    }
+
+    int runOrbit(const HeadlessOptions& opts, RunReport& report) {
+        std::vector<Planet> planets = makePlanets();
+        RunTimer timer(opts);
+        for (int s = 0; s < opts.steps; ++s) {
+            timer.beforeStep(s);
+            profiler().beginFrame();
+            ProfileZone zone("Physics");
+            for (auto& p : planets)
+                p.update(opts.dt);
+        }
+        printTiming(report, opts, planets.size(), timer, opts.steps);
+
+        std::ofstream csv;
+        if (!opts.outFile.empty()) {
+            csv.open(opts.outFile);
+            csv << "name,angle,x,y\n";
+        }
+        for (const auto& p : planets) {
+            sf::Vector2f pos = p.getPosition(0.f, 0.f);
+            report.beginLine(p.name);
+            report.add("angle", p.currentOrbitAngle);
+            report.add("x", pos.x);
+            report.add("y", pos.y);
+            report.endLine();
+            if (csv) csv << p.name << ',' << p.currentOrbitAngle << ',' << pos.x << ',' << pos.y << '\n';
+        }
+        return 0;
+    }
+
+    int runNBody(const HeadlessOptions& opts, RunReport& report) {
+        NBodyWorld world = makeSolarNBody(opts.count > 0 ? opts.count : 2000, opts.seed);
+        world.theta = opts.param("theta", world.theta);
+        world.softening = opts.param("softening", world.softening);
+        // 0 = semi-implicit Euler, 1 = velocity Verlet, 2 = leapfrog, 3 = Yoshida 4
+        SceneConfig config;
+        config.integrator = world.integrator;
+        if (!configParam(opts, "integrator", config)) return 1;
+        world.integrator = config.integrator;
+        std::unique_ptr<JobSystem> pool;
+        if (opts.threads > 0) {
+            pool = std::make_unique<JobSystem>(opts.threads);
+            world.pool = pool.get();
+        }
+        // gpu=1: exact forces from the compute shader instead of the tree
+        std::unique_ptr<GpuNBodyForces> gpu;
+        if (opts.param("gpu", 0.f) != 0.f) {
+            gpu = std::make_unique<GpuNBodyForces>();
+            if (!gpu->ready()) {
+                std::cerr << "GPU forces unavailable: " << gpu->error() << "\n";
+                return 1;
+            }
+            world.gpu = gpu.get();
+        }
+        // direct=1: the shader's exact sum on the CPU, to compare gpu=1 against
+        world.directSum = opts.param("direct", 0.f) != 0.f;
+
+        // Direct-sum energy is O(n^2); only check drift on small systems
+        const bool checkEnergy = world.bodies.size() <= 20000;
+        const double e0 = checkEnergy ? world.totalEnergy() : 0.0;
+
+        // The recording frames the bodies' starting extent
+        ReplayRecorder recorder;
+        const ParticleStore& b = world.bodies;
+        sf::FloatRect extent;
+        if (b.size()) {
+            const auto [minX, maxX] = std::minmax_element(b.x.begin(), b.x.end());
+            const auto [minY, maxY] = std::minmax_element(b.y.begin(), b.y.end());
+            extent = sf::FloatRect(*minX, *minY, *maxX - *minX, *maxY - *minY);
+        }
+        if (!startRecording(opts, recorder, world.bodies, extent)) return 1;
+
+        // Live samples repeat the direct sum, so only on smaller systems still
+        const bool sampleEnergy = checkEnergy && world.bodies.size() <= TELEMETRY_ENERGY_BODIES;
+        auto sample = [&](TelemetrySample& t) {
+            t.bodies = world.bodies.size();
+            if (!sampleEnergy) return;
+            t.energy = world.totalEnergy();
+            t.energyDrift = (t.energy - e0) / std::fabs(e0);
+        };
+        RunTimer timer(opts);
+        for (int s = 0; s < opts.steps; ++s) {
+            timer.beforeStep(s);
+            profiler().beginFrame();
+            world.step(opts.dt);
+            if (recorder.isOpen()) recorder.record(world.bodies);
+            report.afterStep(sample);
+        }
+        report.finish(sample);
+        printTiming(report, opts, world.bodies.size(), timer, opts.steps);
+
+        report.add("integrator", (int)world.integrator);
+        report.add("forces", gpu ? "gpu" : world.directSum ? "direct" : "tree");
+        report.add("theta", world.theta);
+        report.add("tree_nodes", world.treeNodes());
+        if (checkEnergy) {
+            const double e1 = world.totalEnergy();
+            report.add("energy_start", e0);
+            report.add("energy_end", e1);
+            report.add("relative_drift", (e1 - e0) / std::fabs(e0));
+        }
+        report.endLine();
+        finishRecording(report, opts, recorder);
+        dumpParticles(opts, world.bodies);
+        return 0;
+    }
+}
+
+float HeadlessOptions::param(const std::string& key, float fallback) const {
+    auto it = params.find(key);
+    return it != params.end() ? it->second : fallback;
+}
+
+bool parseHeadlessArgs(int argc, char** argv, HeadlessOptions& opts) {
+    if (argc < 3 || std::string(argv[1]) != "--headless") {
+        printUsage();
+        return false;
+    }
+    opts.mode = argv[2];
+    try {
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (i + 1 >= argc) throw std::invalid_argument(arg);
+            std::string value = argv[++i];
+            if (arg == "--steps") opts.steps = std::stoi(value);
+            else if (arg == "--dt") opts.dt = std::stof(value);
+            else if (arg == "--count") opts.count = std::stoi(value);
+            else if (arg == "--seed") opts.seed = static_cast<unsigned>(std::stoul(value));
+            else if (arg == "--threads") opts.threads = std::stoi(value);
+            else if (arg == "--out") opts.outFile = value;
+            else if (arg == "--profile") opts.profilePrefix = value;
+            else if (arg == "--fluids") opts.fluidFile = value;
+            else if (arg == "--config") opts.configFile = value;
+            else if (arg == "--record") opts.recordFile = value;
+            else if (arg == "--telemetry") opts.telemetryTarget = value;
+            else if (arg == "--telemetry-hz") opts.telemetryHz = std::stof(value);
+            else if (arg == "--param") {
+                auto eq = value.find('=');
+                if (eq == std::string::npos) throw std::invalid_argument(value);
+                opts.params[value.substr(0, eq)] = std::stof(value.substr(eq + 1));
+            }
+            else if (arg == "--sweep") opts.sweep.push_back(parseSweepAxis(value));
+            else if (arg == "--jobs") opts.jobs = std::stoi(value);
+            else throw std::invalid_argument(arg);
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Bad argument: " << e.what() << "\n";
+        printUsage();
+        return false;
+    }
+    if (opts.dt <= 0.f || opts.steps < 0) {
+        printUsage();
+        return false;
+    }
+    if (!opts.sweep.empty() && (!opts.recordFile.empty() || !opts.profilePrefix.empty() || !opts.telemetryTarget.empty())) {
+        std::cerr << "--record, --profile and --telemetry cannot be combined with --sweep\n";
+        return false;
+    }
+    // Every run would start its own --threads workers on each of the jobs
+    if (!opts.sweep.empty() && opts.threads > 0 && opts.jobs != 1) {
+        std::cerr << "--threads in a sweep needs --jobs 1\n";
+        return false;
+    }
+    for (const auto& p : opts.params) {
+        if (!modeReadsParam(opts.mode, p.first)) {
+            std::cerr << "Mode " << opts.mode << " has no parameter " << p.first << "\n";
+            return false;
+        }
+    }
+    for (const SweepAxis& axis : opts.sweep) {
+        // The SIMD level is process-wide, so runs sharing the process cannot differ in it
+        if (axis.key == "simd") {
+            std::cerr << "simd cannot be swept; run the sweep once per --param simd=N instead\n";
+            return false;
+        }
+        if (!isSweepOption(axis.key) && !modeReadsParam(opts.mode, axis.key)) {
+            std::cerr << "Mode " << opts.mode << " has no parameter " << axis.key << " to sweep\n";
+            return false;
+        }
+        if (!isWholeNumberKey(axis.key)) continue;
+        for (double v : axis.values) {
+            if (v < 0.0 || v != std::floor(v)) {
+                std::cerr << "Sweep values of " << axis.key << " must be whole numbers, not " << v << "\n";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+    int runMode(const HeadlessOptions& opts, RunReport& report) {
+        if (opts.mode == "collision") return runCollision(opts, report);
+        if (opts.mode == "viscosity") return runViscosity(opts, report);
+        if (opts.mode == "columns") return runColumns(opts, report);
+        if (opts.mode == "projectile") return runProjectile(opts, report);
+        if (opts.mode == "shells") return runShells(opts, report);
+        if (opts.mode == "orbit") return runOrbit(opts, report);
+        if (opts.mode == "nbody") return runNBody(opts, report);
+        std::cerr << "Unknown mode: " << opts.mode << "\n";
+        printUsage();
+        return 1;
+    }
+
+    void applySweepValue(HeadlessOptions& opts, const std::string& key, double value) {
+        if (key == "seed") opts.seed = static_cast<unsigned>(value);
+        else if (key == "count") opts.count = static_cast<int>(value);
+        else if (key == "steps") opts.steps = static_cast<int>(value);
+        else if (key == "dt") opts.dt = static_cast<float>(value);
+        else opts.params[key] = static_cast<float>(value);
+    }
+
+    // A swept value as the run received it
+    std::string sweepValueText(const std::string& key, double value) {
+        if (isWholeNumberKey(key)) return std::to_string(static_cast<long long>(value));
+        std::ostringstream text;
+        text << static_cast<float>(value);
+        return text.str();
+    }
+
+    std::string csvField(const std::string& text) {
+        if (text.find_first_of(",\"\n") == std::string::npos) return text;
+        std::string quoted = "\"";
+        for (char c : text) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        return quoted + '"';
+    }
+
+    // Runs the scene at every point of the sweep grid, the first axis varying
+    // slowest. Every run has its own options, world and report, so runs
+    // share nothing but the job system that schedules them; rows come out
+    // in grid order whichever thread ran them.
+    int runSweep(const HeadlessOptions& opts) {
+        HeadlessOptions base = opts;
+        base.sweep.clear();
+        base.outFile.clear();
+        std::size_t runs = 1;
+        for (const SweepAxis& axis : opts.sweep) runs *= axis.values.size();
+        std::vector<HeadlessOptions> runOpts(runs, base);
+        for (std::size_t r = 0; r < runs; ++r) {
+            std::size_t index = r;
+            for (std::size_t a = opts.sweep.size(); a-- > 0;) {
+                const SweepAxis& axis = opts.sweep[a];
+                applySweepValue(runOpts[r], axis.key, axis.values[index % axis.values.size()]);
+                index /= axis.values.size();
+            }
+        }
+
+        // Claim the profiler for this thread; runs on the workers skip it
+        profiler();
+        std::vector<int> codes(runs, 0);
+        std::vector<std::vector<RunReport::Field>> results(runs);
+        JobSystem pool(opts.jobs);
+        sf::Clock clock;
+        pool.parallelFor(0, static_cast<int>(runs), [&](int, int begin, int end) {
+            for (int r = begin; r < end; ++r) {
+                std::ostringstream discarded;
+                Telemetry off;
+                RunReport report(discarded, off);
+                codes[r] = runMode(runOpts[r], report);
+                results[r] = std::move(report.fields);
+            }
+        });
+        const double wallMs = clock.getElapsedTime().asMicroseconds() / 1000.0;
+
+        // Columns: the swept keys, then every reported field in the order
+        // runs first reported it
+        std::vector<std::string> header;
+        std::map<std::string, std::size_t> column;
+        for (const SweepAxis& axis : opts.sweep) header.push_back("sweep_" + axis.key);
+        header.push_back("exit_code");
+        for (const auto& fields : results) {
+            for (const RunReport::Field& f : fields) {
+                if (column.emplace(f.first, header.size()).second) header.push_back(f.first);
+            }
+        }
+
+        std::ofstream file;
+        if (!opts.outFile.empty()) {
+            file.open(opts.outFile);
+            if (!file) {
+                std::cerr << "Failed to open " << opts.outFile << "\n";
+                return 1;
+            }
+        }
+        std::ostream& out = opts.outFile.empty() ? std::cout : file;
+        for (std::size_t c = 0; c < header.size(); ++c)
+            out << (c ? "," : "") << csvField(header[c]);
+        out << "\n";
+        int failed = 0;
+        std::vector<std::string> row;
+        for (std::size_t r = 0; r < runs; ++r) {
+            row.assign(header.size(), std::string());
+            std::size_t index = r;
+            for (std::size_t a = opts.sweep.size(); a-- > 0;) {
+                const SweepAxis& axis = opts.sweep[a];
+                row[a] = sweepValueText(axis.key, axis.values[index % axis.values.size()]);
+                index /= axis.values.size();
+            }
+            row[opts.sweep.size()] = std::to_string(codes[r]);
+            for (const RunReport::Field& f : results[r])
+                row[column[f.first]] = f.second;
+            for (std::size_t c = 0; c < row.size(); ++c)
+                out << (c ? "," : "") << csvField(row[c]);
+            out << "\n";
+            if (codes[r] != 0) ++failed;
+        }
+        if (!opts.outFile.empty()) {
+            std::cout << "sweep mode=" << opts.mode << " runs=" << runs << " failed=" << failed
+                << " jobs=" << pool.size() << " wall_ms=" << wallMs
+                << " ms_per_run=" << wallMs / runs << "\n";
+        }
+        return failed == 0 ? 0 : 1;
+    }
+}
+
+int runHeadless(const HeadlessOptions& opts) {
+    // 0 = scalar, 1 = NEON, 2 = AVX2; defaults to the best the CPU has
+    setSimdLevel(static_cast<SimdLevel>((int)opts.param("simd", (float)detectSimdLevel())));
+    if (!opts.sweep.empty()) return runSweep(opts);
+    Telemetry telemetry;
+    if (!opts.telemetryTarget.empty() && !telemetry.start(opts.telemetryTarget, opts.telemetryHz)) return 1;
+    RunReport report(std::cout, telemetry);
+    const int code = runMode(opts, report);
+    if (code == 0 && !opts.profilePrefix.empty()) {
+        // Each step is one profiler frame
+        profiler().beginFrame();
+        std::cout << profiler().summary();
+        if (!profiler().writeCsv(opts.profilePrefix + ".csv") ||
+            !profiler().writeChromeTrace(opts.profilePrefix + ".json")) {
+            std::cerr << "Failed to write profile " << opts.profilePrefix << "\n";
+            return 1;
+        }
+    }
+    return code;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+// One dimension of a parameter sweep: an option (seed, count, steps, dt) or a
+// parameter the mode reads, and the values it takes. seed, count and steps
+// take whole numbers only.
+struct SweepAxis {
+    std::string key;
+    std::vector<double> values;
+};
+
+// Options for running a simulation with no window or graphics context.
+struct HeadlessOptions {
+    std::string mode;                    // orbit, nbody, projectile, shells, collision, viscosity or columns
+    int steps = 1000;
+    float dt = 1.f / 240.f;
+    int count = 0;                       // bodies; 0 keeps the interactive scene size
+    unsigned seed = 1;
+    int threads = 0;                     // worker threads; 0 = sequential solver
+    std::string outFile;                 // optional CSV dump of the final state
+    std::string profilePrefix;           // optional profiler dump: <prefix>.csv and <prefix>.json
+    std::string fluidFile;               // fluid table of the viscosity scenes; empty = built-in
+    std::string configFile;              // optional SceneConfig key=value file (collision)
+    std::string recordFile;              // optional replay recording (collision and nbody)
+    std::string telemetryTarget;         // optional live metrics: udp:host:port or tcp:host:port
+    float telemetryHz = 10.f;            // telemetry samples per second
+    std::map<std::string, float> params; // scene parameters, e.g. restitution=0.5
+    std::vector<SweepAxis> sweep;        // run every combination instead of one scene
+    int jobs = 0;                        // sweep runs at once; 0 = hardware concurrency. Must be 1
+                                         // when threads > 0, or every job would start its own workers
+
+    float param(const std::string& key, float fallback) const;
+};
+
+// Parses "--headless <mode> [--steps N] [--dt S] [--count N] [--seed N]
+// [--threads N] [--out file] [--profile prefix] [--fluids file] [--config file] [--record file.rec]
+// [--telemetry udp:host:port|tcp:host:port] [--telemetry-hz N] [--param key=value]... [--sweep key=v1,v2,...|key=first:last:count]...
+// [--jobs N]".
+// Prints usage and returns false on bad input, including --param or --sweep
+// keys the mode does not read, a sweep over simd (which is process-wide),
+// and --threads in a sweep without --jobs 1.
+bool parseHeadlessArgs(int argc, char** argv, HeadlessOptions& opts);
+
+// Runs opts.steps fixed steps, prints timing and a state summary, and
+// returns the process exit code. With sweep axes it instead runs the scene
+// once per point of their grid, opts.jobs runs at a time, and writes one
+// CSV row per run to opts.outFile (or stdout).
+int runHeadless(const HeadlessOptions& opts);
@@ -0,0 +1,81 @@
+#include "heapCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::atomic<std::uint64_t> totalAllocations{ 0 };
+    thread_local std::uint64_t threadAllocations = 0;
+
+    void count() {
+        ++threadAllocations;
+        totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* allocate(std::size_t size) {
+        count();
+        // malloc(0) may return null; operator new may not
+        return std::malloc(size ? size : 1);
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t align) {
+        count();
+        const std::size_t a = static_cast<std::size_t>(align);
+#ifdef _MSC_VER
+        return _aligned_malloc(size ? size : 1, a);
+#else
+        // aligned_alloc wants the size to be a multiple of the alignment
+        return std::aligned_alloc(a, (size + a - 1) / a * a);
+#endif
+    }
+
+    void releaseAligned(void* p) {
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+std::uint64_t heapAllocations() {
+    return totalAllocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t threadHeapAllocations() {
+    return threadAllocations;
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    if (void* p = allocateAligned(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    if (void* p = allocateAligned(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
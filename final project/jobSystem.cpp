@@ -0,0 +1,217 @@
+#include "jobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include "frameArena.h"
+#include "heapCounter.h"
+
+namespace {
+    // Which system and queue the current thread works for
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local int currentIndex = 0;
+    // Jobs running on this thread right now, counting nested waits
+    thread_local int executeDepth = 0;
+}
+
+TaskGraph::Task TaskGraph::add(std::function<void()> fn, std::initializer_list<Task> after) {
+    const Task id = static_cast<Task>(used);
+    if (used == nodes.size()) nodes.emplace_back();
+    Node& node = nodes[used++];
+    node.fn = std::move(fn);
+    node.dependents.clear();
+    node.dependencies = static_cast<int>(after.size());
+    for (Task a : after) nodes[a].dependents.push_back(id);
+    return id;
+}
+
+void TaskGraph::runInOrder() {
+    for (std::size_t i = 0; i < used; ++i) nodes[i].fn();
+}
+
+void JobSystem::JobRing::pushBack(const Job& job) {
+    if (count == ring.size()) {
+        // Unwrap into a ring twice the size
+        std::vector<Job> grown(std::max<std::size_t>(16, 2 * ring.size()));
+        for (std::size_t i = 0; i < count; ++i)
+            grown[i] = ring[(head + i) & (ring.size() - 1)];
+        ring.swap(grown);
+        head = 0;
+    }
+    ring[(head + count) & (ring.size() - 1)] = job;
+    ++count;
+}
+
+JobSystem::JobSystem(int threads) {
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; ++i)
+        queues.push_back(std::make_unique<Queue>());
+    for (int i = 1; i < threads; ++i)
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+int JobSystem::currentQueue() const {
+    return currentSystem == this ? currentIndex : 0;
+}
+
+void JobSystem::push(int queue, const Job& job) {
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->jobs.pushBack(job);
+    }
+    queued.fetch_add(1, std::memory_order_release);
+    // Taking the lock orders this against a worker about to sleep
+    { std::lock_guard<std::mutex> lock(sleepMutex); }
+    wake.notify_one();
+}
+
+bool JobSystem::take(int queue, Job& job) {
+    // Own work first, newest first: its data is still in cache
+    {
+        Queue& own = *queues[queue];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = own.jobs.popBack();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    // Then the oldest work of the others, the biggest left to split off
+    const int n = static_cast<int>(queues.size());
+    for (int i = 1; i < n; ++i) {
+        Queue& victim = *queues[(queue + i) % n];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.jobs.empty()) continue;
+        job = victim.jobs.popFront();
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        queues[queue]->steals.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::execute(int queue, Job job) {
+    const auto start = std::chrono::steady_clock::now();
+    const std::uint64_t allocationsBefore = threadHeapAllocations();
+    ++executeDepth;
+    while (true) {
+        queues[queue]->tasks.fetch_add(1, std::memory_order_relaxed);
+        if (job.graph == nullptr) {
+            job.call(job.fn, job.slot, job.begin, job.end);
+            job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+            break;
+        }
+
+        // Graph task: release its dependents, keep one for this thread
+        TaskGraph::Node& node = job.graph->nodes[job.slot];
+        node.fn();
+        int next = -1;
+        for (TaskGraph::Task d : node.dependents) {
+            if (job.graph->nodes[d].waiting.fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+            if (next < 0) next = d;
+            else push(queue, Job{ nullptr, nullptr, d, 0, 0, job.graph, job.remaining });
+        }
+        job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+        if (next < 0) break;
+        job.slot = next;
+    }
+    // Nested jobs ran inside this one's time; count the outermost only
+    if (--executeDepth == 0) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        queues[queue]->busyNs.fetch_add(ns, std::memory_order_relaxed);
+        queues[queue]->heapAllocations.fetch_add(threadHeapAllocations() - allocationsBefore, std::memory_order_relaxed);
+    }
+}
+
+void JobSystem::helpUntilDone(const std::atomic<int>& remaining) {
+    const int queue = currentQueue();
+    Job job;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (take(queue, job)) execute(queue, job);
+        else std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(int queue) {
+    currentSystem = this;
+    currentIndex = queue;
+    Job job;
+    while (true) {
+        if (take(queue, job)) {
+            execute(queue, job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [&] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
+
+void JobSystem::forChunks(int begin, int end, const void* fn, ChunkFn call, int grain) {
+    if (end <= begin) return;
+    const int count = end - begin;
+    const int chunks = std::clamp(count / std::max(1, grain), 1, slotCount());
+    if (chunks == 1) {
+        call(fn, 0, begin, end);
+        return;
+    }
+    auto chunkBegin = [&](int k) {
+        return begin + static_cast<int>(static_cast<long long>(count) * k / chunks);
+    };
+
+    // Pushed last to first, so this thread works up from chunk 1 while
+    // thieves take the far end
+    std::atomic<int> remaining{ chunks };
+    const int queue = currentQueue();
+    for (int k = chunks - 1; k >= 1; --k)
+        push(queue, Job{ call, fn, k, chunkBegin(k), chunkBegin(k + 1), nullptr, &remaining });
+    execute(queue, Job{ call, fn, 0, begin, chunkBegin(1), nullptr, &remaining });
+    helpUntilDone(remaining);
+}
+
+void JobSystem::run(TaskGraph& graph) {
+    if (graph.used == 0) return;
+    const ArenaScope scratch;
+    FrameVector<TaskGraph::Task> roots;
+    for (std::size_t i = 0; i < graph.used; ++i) {
+        TaskGraph::Node& node = graph.nodes[i];
+        node.waiting.store(node.dependencies, std::memory_order_relaxed);
+        if (node.dependencies == 0) roots.push_back(static_cast<TaskGraph::Task>(i));
+    }
+    if (roots.empty()) return; // every task waits on another: nothing can start
+
+    std::atomic<int> remaining{ static_cast<int>(graph.used) };
+    const int queue = currentQueue();
+    for (std::size_t r = roots.size() - 1; r >= 1; --r)
+        push(queue, Job{ nullptr, nullptr, roots[r], 0, 0, &graph, &remaining });
+    execute(queue, Job{ nullptr, nullptr, roots[0], 0, 0, &graph, &remaining });
+    helpUntilDone(remaining);
+}
+
+JobSystem::ThreadStats JobSystem::threadStats(int thread) const {
+    const Queue& q = *queues[thread];
+    ThreadStats s;
+    s.busyMs = q.busyNs.load(std::memory_order_relaxed) / 1e6;
+    s.tasks = q.tasks.load(std::memory_order_relaxed);
+    s.steals = q.steals.load(std::memory_order_relaxed);
+    s.heapAllocations = q.heapAllocations.load(std::memory_order_relaxed);
+    return s;
+}
+
+void JobSystem::resetStats() {
+    for (auto& q : queues) {
+        q->busyNs.store(0, std::memory_order_relaxed);
+        q->tasks.store(0, std::memory_order_relaxed);
+        q->steals.store(0, std::memory_order_relaxed);
+        q->heapAllocations.store(0, std::memory_order_relaxed);
+    }
+}
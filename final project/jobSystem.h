@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Tasks with dependencies, run by JobSystem::run(). A task starts once every
+// task it was added after has finished. When a finishing task releases
+// others, the thread that ran it carries straight on with one of them, so a
+// chain of stages stays on the calling thread (and in its profiler zones)
+// while each stage fans out with parallelFor.
+class TaskGraph {
+public:
+    using Task = int;
+
+    // Tasks in after must already be in the graph.
+    Task add(std::function<void()> fn, std::initializer_list<Task> after = {});
+    // Drops every task but keeps their storage, so a graph rebuilt each step
+    // stops allocating after the first.
+    void clear() { used = 0; }
+    std::size_t size() const { return used; }
+    // Runs the tasks one by one in the order they were added, which always
+    // respects their dependencies; for callers without a job system.
+    void runInOrder();
+
+private:
+    friend class JobSystem;
+    struct Node {
+        std::function<void()> fn;
+        std::vector<Task> dependents;
+        int dependencies = 0;
+        std::atomic<int> waiting{ 0 };
+
+        Node() = default;
+        Node(const Node& o) : fn(o.fn), dependents(o.dependents), dependencies(o.dependencies) {}
+        Node& operator=(const Node& o) {
+            fn = o.fn;
+            dependents = o.dependents;
+            dependencies = o.dependencies;
+            return *this;
+        }
+    };
+    std::vector<Node> nodes; // nodes[0, used) are live
+    std::size_t used = 0;
+};
+
+// Work-stealing scheduler shared by everything a scene runs in parallel.
+// Every worker owns a deque: it takes its own work from the back, newest
+// first, and when that runs dry steals the oldest work from the front of
+// another's. Threads outside the system (the main or simulation thread)
+// share slot 0. A thread waiting for its work to finish runs other tasks
+// meanwhile, so parallelFor and run() may be called from inside a task.
+//
+// parallelFor splits a range into at most slotCount() chunks of at least
+// `grain` items. Chunk k covers the same items every time for a given range,
+// grain and thread count, and is passed k as its slot, so per-slot outputs
+// merged in slot order are deterministic whichever thread ran each chunk.
+class JobSystem {
+public:
+    // Chunks per thread: enough slack for stealing to even out uneven chunks
+    static constexpr int CHUNKS_PER_THREAD = 4;
+
+    explicit JobSystem(int threads = 0); // 0 = hardware concurrency
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Threads doing work, counting the calling thread.
+    int size() const { return static_cast<int>(workers.size()) + 1; }
+    // Upper bound on the slot parallelFor passes; size per-slot scratch by it.
+    int slotCount() const { return size() == 1 ? 1 : size() * CHUNKS_PER_THREAD; }
+
+    // Calls fn(slot, chunkBegin, chunkEnd) for every chunk and returns once
+    // all have finished. fn is only referenced, never copied, so handing it
+    // a lambda does not allocate.
+    template <class Fn>
+    void parallelFor(int begin, int end, const Fn& fn, int grain = 1) {
+        forChunks(begin, end, &fn, [](const void* f, int slot, int b, int e) {
+            (*static_cast<const Fn*>(f))(slot, b, e);
+        }, grain);
+    }
+    // Runs every task of the graph, respecting dependencies, and returns
+    // once all have finished.
+    void run(TaskGraph& graph);
+
+    // Work done per thread since the counters were last reset; thread 0 is
+    // every caller outside the system.
+    struct ThreadStats {
+        double busyMs = 0.0;
+        std::uint64_t tasks = 0, steals = 0;
+        std::uint64_t heapAllocations = 0; // made by jobs on this thread
+    };
+    ThreadStats threadStats(int thread) const;
+    void resetStats();
+
+private:
+    using ChunkFn = void (*)(const void* fn, int slot, int begin, int end);
+    struct Job {
+        ChunkFn call = nullptr;
+        const void* fn = nullptr;
+        int slot = 0, begin = 0, end = 0;
+        TaskGraph* graph = nullptr; // set for graph tasks; slot is the task
+        std::atomic<int>* remaining = nullptr;
+    };
+    // Double-ended ring that keeps its storage, unlike std::deque, which
+    // frees and reallocates blocks as jobs come and go.
+    class JobRing {
+    public:
+        bool empty() const { return count == 0; }
+        void pushBack(const Job& job);
+        Job popBack() { --count; return ring[(head + count) & (ring.size() - 1)]; }
+        Job popFront() {
+            const Job job = ring[head];
+            head = (head + 1) & (ring.size() - 1);
+            --count;
+            return job;
+        }
+
+    private:
+        std::vector<Job> ring; // power-of-two size
+        std::size_t head = 0, count = 0;
+    };
+    struct Queue {
+        std::mutex mutex;
+        JobRing jobs;
+        std::atomic<std::int64_t> busyNs{ 0 };
+        std::atomic<std::uint64_t> tasks{ 0 }, steals{ 0 }, heapAllocations{ 0 };
+    };
+
+    void forChunks(int begin, int end, const void* fn, ChunkFn call, int grain);
+
+    int currentQueue() const;
+    void push(int queue, const Job& job);
+    bool take(int queue, Job& job);
+    void execute(int queue, Job job);
+    void helpUntilDone(const std::atomic<int>& remaining);
+    void workerLoop(int queue);
+
+    std::vector<std::unique_ptr<Queue>> queues; // slot 0 + one per worker
+    std::vector<std::thread> workers;
+    std::atomic<int> queued{ 0 };
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{ false };
+};
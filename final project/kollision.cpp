@@ -3,177 +3,692 @@
 #include <cmath>
 #include <vector>
 #include <random>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include "kollision.h"
+#include "assets.h"
+#include "circleBatch.h"
+#include "frameArena.h"
+#include "gpuCollision.h"
+#include "jobSystem.h"
+#include "simdKernels.h"
+#include "profiler.h"
+#include "replay.h"
+#include "simulation.h"
+#include "tripleBuffer.h"
 
-struct Ball {
-    sf::CircleShape shape;
-    sf::Vector2f   velocity = { 0.f, 0.f };
-    float          radius;
-    Ball(float r, sf::Vector2f pos) : radius(r) {
-        shape.setRadius(radius);
-        shape.setOrigin(radius, radius);
-        shape.setPosition(pos);
-        shape.setFillColor({ 100, 200, 250 });
-    }
-};
-
-void runCollisionSimulation() {
-    const sf::Vector2u windowSize{ 800, 600 };
-
-    sf::RenderWindow window(
-        sf::VideoMode(windowSize.x, windowSize.y),
-        "Container Collision"
-    );
-    window.setFramerateLimit(60);
-
-    // Legend
-    sf::Font font;
-    font.loadFromFile("OpenSans-Regular.ttf");
-    sf::Text legend("Drag the ball to throw it!", font, 18);
-    legend.setFillColor(sf::Color::White);
-    legend.setPosition(60.f, 20.f);
-
-    // Container bounds
-    sf::FloatRect bounds(50.f, 50.f,
-        windowSize.x - 100.f,
-        windowSize.y - 100.f);
-    sf::RectangleShape containerShape;
-    containerShape.setPosition(bounds.left, bounds.top);
-    containerShape.setSize({ bounds.width, bounds.height });
-    containerShape.setFillColor(sf::Color::Transparent);
-    containerShape.setOutlineColor(sf::Color::White);
-    containerShape.setOutlineThickness(2.f);
-
-    // Random placement
-    std::mt19937 rng{ std::random_device{}() };
+void CollisionWorld::spawn(int count, float radius, float margin, std::mt19937& rng) {
     std::uniform_real_distribution<float> ux(
-        bounds.left + 20.f, bounds.left + bounds.width - 20.f
+        bounds.left + margin, bounds.left + bounds.width - margin
     );
     std::uniform_real_distribution<float> uy(
-        bounds.top + 20.f, bounds.top + bounds.height - 20.f
+        bounds.top + margin, bounds.top + bounds.height - margin
     );
+    balls.reserve(balls.size() + count);
+    for (int i = 0; i < count; ++i) {
+        float x = ux(rng); // sequenced so a seed gives the same scene everywhere
+        balls.add(x, uy(rng), radius);
+    }
+    // New bodies start awake, and asleep() is valid before the first step
+    sleep.resize(balls.size());
+}
+
+namespace {
+    // Earliest t in [0, tMax] at which two spheres, offset by d and closing
+    // with relative velocity w, are reach apart; -1 if they do not meet or
+    // already overlap (the discrete solver handles those).
+    float sweptSphereToi(float dx, float dy, float wx, float wy, float reach, float tMax) {
+        const float c = dx * dx + dy * dy - reach * reach;
+        const float b = dx * wx + dy * wy;
+        if (c <= 0.f || b >= 0.f) return -1.f;
+        const float a = wx * wx + wy * wy;
+        const float disc = b * b - a * c;
+        if (disc < 0.f) return -1.f;
+        const float t = (-b - std::sqrt(disc)) / a;
+        return t <= tMax ? t : -1.f;
+    }
+
+    // Time for position p with radius r and velocity v to reach [lo, hi]'s edge.
+    float wallToi(float p, float v, float r, float lo, float hi) {
+        if (v < 0.f && p - r >= lo) return (lo + r - p) / v;
+        if (v > 0.f && p + r <= hi) return (hi - r - p) / v;
+        return -1.f;
+    }
+
+    // A range of a world's bodies as an integrator system (integrators.h).
+    // The field is gravity and drag, which depends on velocity alone, so
+    // there is nothing to compute ahead and each kick takes the drag of
+    // the velocity at hand. Sleeping bodies are not kicked.
+    template <class Drag, class Walls>
+    struct FieldRange {
+        ParticleStore& b;
+        const char* asleep;
+        int begin, end;
+        float g, k;
+        WallBox box;
+
+        void computeAccel() {}
+        bool accelReady() const { return true; }
+        void kick(float h) {
+            if constexpr (Drag::MODEL == DragModel::Quadratic) {
+                for (int i = begin; i < end; ++i) {
+                    if (asleep[i]) continue;
+                    const float c = Drag::coefficient(b.vx[i], b.vy[i], k);
+                    b.vx[i] -= c * b.vx[i] * h;
+                    b.vy[i] += (g - c * b.vy[i]) * h;
+                }
+            }
+            else {
+                // No field at all in the container scene
+                if (Drag::MODEL == DragModel::None && g == 0.f) return;
+                simdKernels().kickWithDrag(b.vx.data(), b.vy.data(), asleep, begin, end,
+                    Drag::coefficient(0.f, 0.f, k), g, h);
+            }
+        }
+        void drift(float h) {
+            if constexpr (Walls::MODE == WallMode::Box) {
+                simdKernels().driftCollideWalls(b.x.data(), b.y.data(), b.vx.data(), b.vy.data(),
+                    b.radius.data(), begin, end, h, box);
+            }
+            else {
+                for (int i = begin; i < end; ++i) {
+                    b.x[i] += b.vx[i] * h;
+                    b.y[i] += b.vy[i] * h;
+                }
+            }
+        }
+    };
+}
+
+void CollisionWorld::sweepFastBodies(float dt) {
+    const int count = (int)balls.size();
+    const ArenaScope scratch;
+    FrameVector<int> fastBodies;
+    float maxR = 0.f, maxDisp2 = 0.f;
+    for (int i = 0; i < count; ++i) {
+        const float disp2 = (balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i]) * dt * dt;
+        const float limit = ccdThreshold * balls.radius[i];
+        if (disp2 > limit * limit) fastBodies.push_back(i);
+        maxDisp2 = std::max(maxDisp2, disp2);
+        maxR = std::max(maxR, balls.radius[i]);
+    }
+    sweptBodies = fastBodies.size();
+    ccdHits = 0;
+    if (fastBodies.empty()) return;
+
+    // Last step's grid still indexes everyone near their current position
+    const bool useGrid = broadphase == BroadphaseMode::Grid && grid.bodyCount() == balls.size();
+    // A rewound start position is only meaningful along its own new path, so
+    // each body takes at most one impact per step
+    FrameVector<char> sweptHit(count, 0); // body already bounced by CCD this step
+    const float maxDisp = std::sqrt(maxDisp2);
+    for (int i : fastBodies) {
+        if (sweptHit[i]) continue;
+        const float r = balls.radius[i];
+        const float ex = balls.x[i] + balls.vx[i] * dt, ey = balls.y[i] + balls.vy[i] * dt;
+        const float margin = r + maxR + maxDisp;
+        const sf::FloatRect swept(std::min(balls.x[i], ex) - margin, std::min(balls.y[i], ey) - margin,
+            std::fabs(ex - balls.x[i]) + 2.f * margin, std::fabs(ey - balls.y[i]) + 2.f * margin);
+
+        sweepCandidates.clear();
+        if (useGrid) grid.query(swept, sweepCandidates);
+
+        // Earliest impact along the step: another ball, or a wall
+        float toi = dt;
+        int hit = -1;
+        auto test = [&](int j) {
+            if (j == i || sweptHit[j]) return;
+            float t = sweptSphereToi(balls.x[j] - balls.x[i], balls.y[j] - balls.y[i],
+                balls.vx[j] - balls.vx[i], balls.vy[j] - balls.vy[i], r + balls.radius[j], toi);
+            if (t >= 0.f && t < toi) {
+                toi = t;
+                hit = j;
+            }
+        };
+        if (useGrid)
+            for (int j : sweepCandidates) test(j);
+        else
+            for (int j = 0; j < count; ++j) test(j);
+
+        const bool walls = config.walls == WallMode::Box;
+        const float tx = walls ? wallToi(balls.x[i], balls.vx[i], r, bounds.left, bounds.left + bounds.width) : -1.f;
+        const float ty = walls ? wallToi(balls.y[i], balls.vy[i], r, bounds.top, bounds.top + bounds.height) : -1.f;
+        const bool wallX = tx >= 0.f && tx < toi;
+        const bool wallY = ty >= 0.f && ty < toi && (!wallX || ty < tx);
+        if (hit < 0 && !wallX && !wallY) continue;
+        ++ccdHits;
+        sweptHit[i] = 1;
+
+        // Respond at the time of impact, then rewind the start position along
+        // the new velocity so the regular drift ends where the bounce would
+        if (wallX || wallY) {
+            toi = wallY ? ty : tx;
+            const float px = balls.x[i] + balls.vx[i] * toi, py = balls.y[i] + balls.vy[i] * toi;
+            if (wallY) balls.vy[i] *= -config.restitution;
+            else balls.vx[i] *= -config.restitution;
+            balls.x[i] = px - balls.vx[i] * toi;
+            balls.y[i] = py - balls.vy[i] * toi;
+            continue;
+        }
+        const int j = hit;
+        sweptHit[j] = 1;
+        sleep.wake(j);
+        const float pix = balls.x[i] + balls.vx[i] * toi, piy = balls.y[i] + balls.vy[i] * toi;
+        const float pjx = balls.x[j] + balls.vx[j] * toi, pjy = balls.y[j] + balls.vy[j] * toi;
+        const float invI = inverseMass(i), invJ = inverseMass(j);
+        const float invSum = invI + invJ;
+        const float dist = std::hypot(pjx - pix, pjy - piy);
+        if (invSum <= 0.f || dist <= 0.f) continue;
+        const float nx = (pjx - pix) / dist, ny = (pjy - piy) / dist;
+        const float vrel = (balls.vx[i] - balls.vx[j]) * nx + (balls.vy[i] - balls.vy[j]) * ny;
+        const float jimp = (1 + config.restitution) * vrel / invSum;
+        balls.vx[i] -= jimp * invI * nx;
+        balls.vy[i] -= jimp * invI * ny;
+        balls.vx[j] += jimp * invJ * nx;
+        balls.vy[j] += jimp * invJ * ny;
+        balls.x[i] = pix - balls.vx[i] * toi;
+        balls.y[i] = piy - balls.vy[i] * toi;
+        balls.x[j] = pjx - balls.vx[j] * toi;
+        balls.y[j] = pjy - balls.vy[j] * toi;
+    }
+}
+
+void CollisionWorld::wakeTouched() {
+    // A moving body touching a sleeping one wakes its whole island; resting
+    // neighbours leave it asleep, which is what lets piles settle
+    const float wakeSpeed2 = sleep.sleepSpeed * sleep.sleepSpeed;
+    for (const BodyPair& pair : pairs) {
+        const bool sa = sleep.asleep(pair.a), sb = sleep.asleep(pair.b);
+        if (sa == sb || !touching(pair)) continue;
+        const int mover = sa ? pair.b : pair.a;
+        const float v2 = balls.vx[mover] * balls.vx[mover] + balls.vy[mover] * balls.vy[mover];
+        if (v2 >= wakeSpeed2) sleep.wake(sa ? pair.a : pair.b);
+    }
+}
+
+bool CollisionWorld::touching(const BodyPair& pair) const {
+    float dx = balls.x[pair.b] - balls.x[pair.a];
+    float dy = balls.y[pair.b] - balls.y[pair.a];
+    float minD = balls.radius[pair.a] + balls.radius[pair.b];
+    float d2 = dx * dx + dy * dy;
+    return d2 < minD * minD && d2 > 0.f;
+}
+
+void CollisionWorld::resolveContact(const BodyPair& pair) {
+    const int a = pair.a, b = pair.b;
+    float dx = balls.x[b] - balls.x[a];
+    float dy = balls.y[b] - balls.y[a];
+    float dist = std::hypot(dx, dy);
+    float minD = balls.radius[a] + balls.radius[b];
+    if (dist < minD && dist > 0.f) {
+        // Sleeping bodies act as static until something wakes them
+        float invA = inverseMass(a), invB = inverseMass(b);
+        float invSum = invA + invB;
+        if (invSum <= 0.f) return;
+        float nx = dx / dist, ny = dy / dist;
+        // Closing speed along the normal; only approaching pairs get an impulse
+        float vrel = (balls.vx[a] - balls.vx[b]) * nx
+            + (balls.vy[a] - balls.vy[b]) * ny;
+        if (vrel > 0.f) {
+            float jimp = (1 + config.restitution) * vrel / invSum;
+            balls.vx[a] -= jimp * invA * nx;
+            balls.vy[a] -= jimp * invA * ny;
+            balls.vx[b] += jimp * invB * nx;
+            balls.vy[b] += jimp * invB * ny;
+            float push = (minD - dist) / invSum;
+            balls.x[a] -= nx * push * invA;
+            balls.y[a] -= ny * push * invA;
+            balls.x[b] += nx * push * invB;
+            balls.y[b] += ny * push * invB;
+        }
+    }
+}
+
+void CollisionWorld::solveColoured() {
+    static constexpr int MAX_COLOURS = 64; // one bit per colour; the rest overflow
+    const int pairCount = (int)pairs.size();
+    const ArenaScope scratch;
+
+    // Which candidates touch right now (read-only, so parallel)
+    FrameVector<char> touchingFlags(pairCount);
+    pool->parallelFor(0, pairCount, [&](int, int b, int e) {
+        for (int i = b; i < e; ++i)
+            touchingFlags[i] = touching(pairs[i]);
+    }, 2048);
+
+    // Greedy colouring in candidate order, then bucket pairs by colour
+    FrameVector<unsigned long long> bodyColours(balls.size(), 0ull); // bit c set = body used by colour c
+    FrameVector<unsigned char> pairColour(pairCount);
+    FrameVector<int> colourStart(MAX_COLOURS + 2, 0);
+    contacts = 0;
+    for (int i = 0; i < pairCount; ++i) {
+        if (!touchingFlags[i]) continue;
+        ++contacts;
+        const BodyPair& p = pairs[i];
+        unsigned long long used = bodyColours[p.a] | bodyColours[p.b];
+        int c = 0;
+        while (c < MAX_COLOURS && (used & (1ull << c))) ++c;
+        if (c < MAX_COLOURS) {
+            bodyColours[p.a] |= 1ull << c;
+            bodyColours[p.b] |= 1ull << c;
+        }
+        pairColour[i] = static_cast<unsigned char>(c);
+        ++colourStart[c + 1];
+    }
+    for (int c = 0; c <= MAX_COLOURS; ++c)
+        colourStart[c + 1] += colourStart[c];
+    colouredPairs.resize(contacts);
+    for (int i = 0; i < pairCount; ++i) {
+        if (touchingFlags[i])
+            colouredPairs[colourStart[pairColour[i]]++] = pairs[i];
+    }
+    // The scatter advanced every start to the next colour's start; shift back
+    for (int c = MAX_COLOURS + 1; c > 0; --c)
+        colourStart[c] = colourStart[c - 1];
+    colourStart[0] = 0;
+
+    // Pairs of one colour share no body, so each batch solves in parallel
+    colours = 0;
+    for (int c = 0; c < MAX_COLOURS; ++c) {
+        const int b = colourStart[c], e = colourStart[c + 1];
+        if (b == e) continue;
+        ++colours;
+        pool->parallelFor(b, e, [&](int, int cb, int ce) {
+            for (int i = cb; i < ce; ++i)
+                resolveContact(colouredPairs[i]);
+        }, 256);
+    }
+    for (int i = colourStart[MAX_COLOURS]; i < colourStart[MAX_COLOURS + 1]; ++i)
+        resolveContact(colouredPairs[i]);
+}
+
+float CollisionWorld::integrate(float dt) {
+    float maxR = 0.f;
+    withSceneConfig(config, [&](auto integrator, auto drag, auto walls) {
+        maxR = integrateWith<decltype(integrator), decltype(drag), decltype(walls)>(dt);
+    });
+    return maxR;
+}
+
+template <class Integrator, class Drag, class Walls>
+float CollisionWorld::integrateWith(float dt) {
+    // The field moves bodies; contacts change velocity afterwards
+    auto move = [&](int b, int e) {
+        FieldRange<Drag, Walls> range{ balls, sleep.sleepFlags(), b, e, config.gravity, config.drag,
+            WallBox{ bounds.left, bounds.top, bounds.left + bounds.width, bounds.top + bounds.height, config.restitution } };
+        Integrator::step(range, dt);
+    };
+    const int count = (int)balls.size();
+    float maxR = 0.f;
+    if (pool) {
+        slotMaxR.assign(pool->slotCount(), 0.f);
+        pool->parallelFor(0, count, [&](int slot, int b, int e) {
+            move(b, e);
+            for (int i = b; i < e; ++i)
+                slotMaxR[slot] = std::max(slotMaxR[slot], balls.radius[i]);
+        }, 1024);
+        for (float r : slotMaxR) maxR = std::max(maxR, r);
+    }
+    else {
+        move(0, count);
+        for (int i = 0; i < count; ++i)
+            maxR = std::max(maxR, balls.radius[i]);
+    }
+    return maxR;
+}
+
+void CollisionWorld::findCandidatePairs(float maxR) {
+    const int count = (int)balls.size();
+    const bool anyAsleep = sleep.sleepingCount() > 0;
+    if (broadphase == BroadphaseMode::Grid) {
+        grid.build(balls.x.data(), balls.y.data(), count, 2.f * maxR, bounds);
+        if (anyAsleep)
+            grid.findAwakePairs(balls.x.data(), balls.y.data(), balls.radius.data(), sleep.sleepFlags(), pairs, bpStats);
+        else if (pool)
+            grid.findPairs(balls.x.data(), balls.y.data(), balls.radius.data(), pairs, bpStats, *pool);
+        else
+            grid.findPairs(balls.x.data(), balls.y.data(), balls.radius.data(), pairs, bpStats);
+    }
+    else {
+        bruteForcePairs(balls.x.data(), balls.y.data(), balls.radius.data(), count, pairs, bpStats);
+        if (anyAsleep) {
+            pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [&](const BodyPair& p) {
+                return sleep.asleep(p.a) && sleep.asleep(p.b);
+            }), pairs.end());
+        }
+    }
+}
 
-    std::vector<Ball> balls;
-    balls.reserve(10);
-    for (int i = 0; i < 10; ++i) {
-        balls.emplace_back(15.f, sf::Vector2f(ux(rng), uy(rng)));
+void CollisionWorld::solveContacts() {
+    if (sleep.sleepingCount() > 0) wakeTouched();
+    if (pool) {
+        solveColoured();
+        return;
+    }
+    contacts = 0;
+    colours = 0;
+    contactPairs.clear();
+    for (const BodyPair& pair : pairs) {
+        if (!touching(pair)) continue;
+        ++contacts;
+        contactPairs.push_back(pair);
+        resolveContact(pair);
     }
+}
+
+void CollisionWorld::step(float dt) {
+    sleep.resize(balls.size());
+    if (!allowSleep && sleep.sleepingCount() > 0) sleep.wakeAll();
+
+    // Rebuilt every step: the tasks capture this, which a copied world
+    // would otherwise share. Each stage fans out over the pool itself.
+    stepDt = dt;
+    stages.clear();
+    const auto sweep = stages.add([this] {
+        // Sweep fast bodies so they cannot tunnel this step
+        ProfileZone zone("CCD");
+        if (ccd) sweepFastBodies(stepDt);
+    });
+    const auto move = stages.add([this] {
+        ProfileZone zone("Integrate");
+        stepMaxR = integrate(stepDt);
+    }, { sweep });
+    const auto broad = stages.add([this] {
+        ProfileZone zone("Broadphase");
+        findCandidatePairs(stepMaxR);
+    }, { move });
+    const auto solve = stages.add([this] {
+        // Narrowphase: ball-ball collisions (inelastic)
+        ProfileZone zone("Solve");
+        solveContacts();
+    }, { broad });
+    stages.add([this] {
+        ProfileZone zone("Sleep");
+        if (allowSleep)
+            sleep.update(balls, pool ? colouredPairs : contactPairs, stepDt);
+    }, { solve });
+
+    if (pool) pool->run(stages);
+    else stages.runInOrder();
+}
+
+std::size_t CollisionWorld::memoryBytes() const {
+    return balls.memoryBytes() + grid.memoryBytes()
+        + sleep.memoryBytes() + capacityBytes(pairs, contactPairs, sweepCandidates, colouredPairs, slotMaxR);
+}
+
+namespace {
+    class CollisionScene : public Simulation {
+    public:
+        WindowSettings windowSettings() const override {
+            return { sf::VideoMode(WIDTH, HEIGHT), "Container Collision" };
+        }
+        // The solver runs on its own thread while the last snapshot is drawn
+        bool pipelined() const override { return true; }
+
+        void start(sf::RenderWindow& window, JobSystem& pool) override {
+            view = window.getDefaultView();
+
+            // Legend
+            const sf::Font& font = assets().font("OpenSans-Regular.ttf");
+            legend = sf::Text("Drag the ball to throw it!   B: broadphase   N: +500 balls   C: CCD   Z: sleeping   G: GPU   F5: record", font, 18);
+            legend.setFillColor(sf::Color::White);
+            legend.setPosition(60.f, 20.f);
 
-    // Drag state
-    bool dragging = false;
-    int dragIndex = -1;
-    sf::Vector2f dragStart;
-    sf::Clock clock;
+            // Broadphase readout
+            stats = sf::Text("", font, 14);
+            stats.setFillColor(sf::Color(180, 180, 180));
+            stats.setPosition(60.f, HEIGHT - 40.f);
 
-    const float restitution = 0.8f;
-    while (window.isOpen()) {
-        sf::Event e;
-        while (window.pollEvent(e)) {
-            if (e.type == sf::Event::Closed)
-                window.close();
+            // Container bounds
+            world.bounds = sf::FloatRect(50.f, 50.f,
+                WIDTH - 100.f,
+                HEIGHT - 100.f);
+            containerShape.setPosition(world.bounds.left, world.bounds.top);
+            containerShape.setSize({ world.bounds.width, world.bounds.height });
+            containerShape.setFillColor(sf::Color::Transparent);
+            containerShape.setOutlineColor(sf::Color::White);
+            containerShape.setOutlineThickness(2.f);
+
+            // Random placement, reproducible from the printed seed
+            seed = sessionSeed();
+            rng.seed(seed);
+            world.spawn(10, 15.f, 20.f, rng);
+
+            // All cores work on the solver
+            world.pool = &pool;
+        }
+
+        void handleEvent(const sf::Event& e, sf::RenderWindow& window) override {
+            ParticleStore& balls = world.balls;
             if (e.type == sf::Event::KeyPressed &&
                 e.key.code == sf::Keyboard::Space) {
-                for (auto& b : balls)
-                    b.velocity = { 0.f, 0.f };
+                editBalls([&] {
+                    std::fill(balls.vx.begin(), balls.vx.end(), 0.f);
+                    std::fill(balls.vy.begin(), balls.vy.end(), 0.f);
+                });
                 dragging = false;
             }
+            if (e.type == sf::Event::KeyPressed &&
+                e.key.code == sf::Keyboard::G) {
+                // The context is made on first use, on the thread that steps
+                if (!gpu) gpu = std::make_unique<GpuCollisionWorld>();
+                if (onGpu) {
+                    gpu->download(balls);
+                    world.sleep.wakeAll();
+                    onGpu = false;
+                }
+                else if (gpu->ready() && GpuCollisionWorld::supports(world.config)) {
+                    // A recording needs the balls every step, and they stay on the GPU
+                    stopRecording();
+                    gpu->bounds = world.bounds;
+                    gpu->config = world.config;
+                    gpu->upload(balls);
+                    onGpu = true;
+                }
+            }
+            if (e.type == sf::Event::KeyPressed &&
+                e.key.code == sf::Keyboard::B) {
+                world.broadphase = world.broadphase == BroadphaseMode::Grid
+                    ? BroadphaseMode::BruteForce : BroadphaseMode::Grid;
+            }
+            if (e.type == sf::Event::KeyPressed &&
+                e.key.code == sf::Keyboard::Z) {
+                world.allowSleep = !world.allowSleep;
+            }
+            if (e.type == sf::Event::KeyPressed &&
+                e.key.code == sf::Keyboard::F5) {
+                if (recorder.isOpen()) stopRecording();
+                else if (!onGpu) recorder.open("collision.rec", balls, 1.f / stepHz(), seed, world.bounds);
+            }
+            if (e.type == sf::Event::KeyPressed &&
+                e.key.code == sf::Keyboard::C) {
+                world.ccd = !world.ccd;
+            }
+            if (e.type == sf::Event::KeyPressed &&
+                e.key.code == sf::Keyboard::N) {
+                // Load-test balls: small so the box can hold thousands.
+                // A recording has a fixed body count, so it ends here
+                stopRecording();
+                editBalls([&] { world.spawn(500, 4.f, 4.f, rng); });
+            }
             if (e.type == sf::Event::MouseButtonPressed &&
                 e.mouseButton.button == sf::Mouse::Left) {
                 sf::Vector2f m = window.mapPixelToCoords(
-                    { e.mouseButton.x, e.mouseButton.y }
+                    { e.mouseButton.x, e.mouseButton.y }, view
                 );
-                for (int i = 0; i < (int)balls.size(); ++i) {
-                    float d = std::hypot(
-                        m.x - balls[i].shape.getPosition().x,
-                        m.y - balls[i].shape.getPosition().y
-                    );
-                    if (d <= balls[i].radius) {
-                        dragging = true;
-                        dragIndex = i;
-                        dragStart = m;
-                        balls[i].velocity = { 0.f, 0.f };
-                        break;
+                editBalls([&] {
+                    for (int i = 0; i < (int)balls.size(); ++i) {
+                        float d = std::hypot(m.x - balls.x[i], m.y - balls.y[i]);
+                        if (d <= balls.radius[i]) {
+                            dragging = true;
+                            dragIndex = i;
+                            dragStart = m;
+                            balls.vx[i] = balls.vy[i] = 0.f;
+                            break;
+                        }
                     }
-                }
+                });
             }
             if (e.type == sf::Event::MouseButtonReleased &&
                 e.mouseButton.button == sf::Mouse::Left &&
                 dragging) {
                 sf::Vector2f m = window.mapPixelToCoords(
-                    { e.mouseButton.x, e.mouseButton.y }
+                    { e.mouseButton.x, e.mouseButton.y }, view
                 );
-                balls[dragIndex].velocity = (m - dragStart) * 5.f;
+                editBalls([&] {
+                    balls.vx[dragIndex] = (m.x - dragStart.x) * 5.f;
+                    balls.vy[dragIndex] = (m.y - dragStart.y) * 5.f;
+                });
+                world.sleep.wake(dragIndex);
                 dragging = false;
             }
         }
 
-        float dt = clock.restart().asSeconds();
+        void step(float dt) override {
+            if (onGpu) {
+                gpu->step(dt);
+                return;
+            }
+            world.balls.savePrevious();
+            world.step(dt);
+            if (recorder.isOpen()) recorder.record(world.balls);
+        }
 
-        // Move & wall collision
-        for (auto& b : balls) {
-            b.shape.move(b.velocity * dt);
-            auto p = b.shape.getPosition();
-            if (p.x - b.radius < bounds.left) {
-                b.shape.setPosition(bounds.left + b.radius, p.y);
-                b.velocity.x *= -restitution;
+        void update(sf::RenderWindow&, const FrameInfo& frame) override {
+            CollisionSnapshot& snap = snapshots.back();
+            std::ostringstream ss;
+            if (onGpu) {
+                // The quads are written on the GPU; only the counters come back
+                const GpuCollisionWorld::Counters c = gpu->counters();
+                ss << "GPU grid | balls: " << gpu->size()
+                    << " | candidates: " << c.candidates
+                    << " | contacts: " << c.contacts
+                    << " | physics: " << frame.physicsMs << " ms (" << frame.steps << " steps)";
+                snap.gpu = gpu->draw(snap.gpuBatch, frame.alpha, ballColor);
+                // Only where vertex buffers are missing: draw from the CPU
+                if (!snap.gpu) gpu->download(world.balls);
             }
-            if (p.x + b.radius > bounds.left + bounds.width) {
-                b.shape.setPosition(
-                    bounds.left + bounds.width - b.radius, p.y
-                );
-                b.velocity.x *= -restitution;
+            else {
+                snap.gpu = false;
+                ss << (world.broadphase == BroadphaseMode::Grid ? "Grid" : "Brute force")
+                    << " | balls: " << world.balls.size() << " (" << world.sleep.sleepingCount() << " asleep)"
+                    << " | tested: " << world.bpStats.testedPairs
+                    << " | candidates: " << world.bpStats.candidatePairs
+                    << " | contacts: " << world.contacts
+                    << " in " << world.colours << " colours on " << world.pool->size() << " threads"
+                    << " | CCD: " << (world.ccd ? "on" : "off") << ", " << world.sweptBodies << " swept"
+                    << " | physics: " << frame.physicsMs << " ms (" << frame.steps << " steps)";
+                if (gpu && !gpu->ready()) ss << " | GPU unavailable: " << gpu->error();
             }
-            if (p.y - b.radius < bounds.top) {
-                b.shape.setPosition(p.x, bounds.top + b.radius);
-                b.velocity.y *= -restitution;
+            if (recorder.isOpen()) ss << " | REC " << recorder.frameCount();
+
+            if (!snap.gpu) {
+                const ParticleStore& balls = world.balls;
+                snap.x.resize(balls.size());
+                snap.y.resize(balls.size());
+                for (std::size_t i = 0; i < balls.size(); ++i) {
+                    snap.x[i] = balls.renderX(i, frame.alpha);
+                    snap.y[i] = balls.renderY(i, frame.alpha);
+                }
+                snap.radius.assign(balls.radius.begin(), balls.radius.end());
+            }
+            snap.stats = ss.str();
+            snap.dragging = dragging;
+            snap.dragStart = dragStart;
+            snapshots.publish();
+        }
+
+        void render(sf::RenderWindow& window, const FrameInfo&) override {
+            const CollisionSnapshot& snap = snapshots.acquire();
+            stats.setString(snap.stats);
+            window.draw(legend);
+            window.draw(stats);
+            window.draw(containerShape);
+            // All balls go out in one batched draw call
+            if (snap.gpu) window.draw(snap.gpuBatch);
+            else {
+                while (ballBatch.size() < snap.x.size())
+                    ballBatch.add(0.f, 0.f, 0.f, ballColor);
+                for (std::size_t i = 0; i < snap.x.size(); ++i)
+                    ballBatch.set(i, snap.x[i], snap.y[i], snap.radius[i]);
+                ballBatch.upload();
+                window.draw(ballBatch);
             }
-            if (p.y + b.radius > bounds.top + bounds.height) {
-                b.shape.setPosition(
-                    p.x, bounds.top + bounds.height - b.radius
+            if (snap.dragging) {
+                sf::Vector2f m = window.mapPixelToCoords(
+                    sf::Mouse::getPosition(window)
                 );
-                b.velocity.y *= -restitution;
+                sf::Vertex line[] = {
+                    {snap.dragStart, sf::Color::Yellow},
+                    {m,         sf::Color::Yellow}
+                };
+                window.draw(line, 2, sf::Lines);
             }
         }
 
-        // Ball-ball collisions (inelastic)
-        for (int i = 0; i < (int)balls.size(); ++i) {
-            for (int j = i + 1; j < (int)balls.size(); ++j) {
-                auto& A = balls[i], & B = balls[j];
-                sf::Vector2f d = B.shape.getPosition() - A.shape.getPosition();
-                float dist = std::hypot(d.x, d.y);
-                float minD = A.radius + B.radius;
-                if (dist < minD && dist > 0.f) {
-                    sf::Vector2f n = d / dist;
-                    sf::Vector2f rel = A.velocity - B.velocity;
-                    float vrel = rel.x * n.x + rel.y * n.y;
-                    if (vrel < 0.f) {
-                        float jimp = -(1 + restitution) * vrel / 2.f;
-                        sf::Vector2f P = jimp * n;
-                        A.velocity += P;
-                        B.velocity -= P;
-                        float overlap = minD - dist;
-                        A.shape.move(-n * (overlap * 0.5f));
-                        B.shape.move(n * (overlap * 0.5f));
-                    }
-                }
-            }
+        ~CollisionScene() override { stopRecording(); }
+
+    private:
+        static constexpr unsigned WIDTH = 800, HEIGHT = 600;
+
+        // What render() draws, written by update()
+        struct CollisionSnapshot {
+            std::vector<float> x, y, radius; // interpolated to the frame
+            // On the GPU the quads are written straight into this batch instead
+            CircleBatch gpuBatch;
+            bool gpu = false;
+            std::string stats;
+            bool dragging = false;
+            sf::Vector2f dragStart;
+        };
+
+        void stopRecording() {
+            if (!recorder.isOpen()) return;
+            const std::size_t frames = recorder.frameCount();
+            if (recorder.close()) std::cout << "Recorded " << frames << " frames to collision.rec\n";
         }
 
-        // Render
-        window.clear(sf::Color::Black);
-        window.draw(legend);
-        window.draw(containerShape);
-        for (auto& b : balls)
-            window.draw(b.shape);
-        if (dragging) {
-            sf::Vector2f m = window.mapPixelToCoords(
-                sf::Mouse::getPosition(window)
-            );
-            sf::Vertex line[] = {
-                {dragStart, sf::Color::Yellow},
-                {m,         sf::Color::Yellow}
-            };
-            window.draw(line, 2, sf::Lines);
+        // On the GPU the balls live there; an edit brings them back for the
+        // one event and sends them up again
+        template <class Edit>
+        void editBalls(Edit edit) {
+            if (onGpu) gpu->download(world.balls);
+            edit();
+            if (onGpu) gpu->upload(world.balls);
         }
-        window.display();
-    }
+
+        // Simulation thread
+        CollisionWorld world;
+        unsigned seed = 0;
+        std::mt19937 rng;
+        sf::View view; // maps mouse events without touching the window's view
+
+        // Drag state
+        bool dragging = false;
+        int dragIndex = -1;
+        sf::Vector2f dragStart;
+
+        // G steps on the GPU instead (gpuCollision.h): no CCD, no sleeping
+        std::unique_ptr<GpuCollisionWorld> gpu;
+        bool onGpu = false;
+
+        // F5 records every step to collision.rec, for "final project.exe --replay"
+        ReplayRecorder recorder;
+
+        TripleBuffer<CollisionSnapshot> snapshots;
+
+        // Main thread
+        sf::Text legend, stats;
+        sf::RectangleShape containerShape;
+        CircleBatch ballBatch;
+        const sf::Color ballColor{ 100, 200, 250 };
+    };
+}
+
+void runCollisionSimulation() {
+    CollisionScene scene;
+    runSimulation(scene);
 }
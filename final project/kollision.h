@@ -0,0 +1,76 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <random>
+#include <vector>
+#include "jobSystem.h"
+#include "particleStore.h"
+#include "sceneConfig.h"
+#include "spatialGrid.h"
+#include "sleep.h"
+
+// Physics of the container-collision scene, independent of any window so
+// it can run interactively or headless.
+struct CollisionWorld {
+    ParticleStore balls;
+    sf::FloatRect bounds;
+    // Integrator, field and walls. The container scene has no field: no
+    // gravity, no drag, semi-implicit Euler between four walls.
+    SceneConfig config;
+    BroadphaseMode broadphase = BroadphaseMode::Grid;
+    // Bodies moving more than ccdThreshold * radius in a step are swept
+    // against walls and other balls before the discrete step, so fast throws
+    // cannot tunnel through anything.
+    bool ccd = true;
+    float ccdThreshold = 0.5f;
+    // Resting islands stop being pair-tested until something hits them.
+    // Call sleep.wake(i) after changing a body's velocity from outside.
+    bool allowSleep = true;
+    SleepSystem sleep;
+    // When set, every phase runs on the pool and contacts are solved in
+    // graph-coloured batches; results depend only on the seed, not on
+    // the thread count. Null keeps the sequential solver.
+    JobSystem* pool = nullptr;
+
+    // Filled by every step
+    BroadphaseStats bpStats;
+    std::size_t contacts = 0;
+    std::size_t colours = 0; // contact batches solved in parallel
+    std::size_t sweptBodies = 0, ccdHits = 0;
+
+    // Scatters count balls uniformly inside the bounds, margin away from the walls.
+    void spawn(int count, float radius, float margin, std::mt19937& rng);
+    // One fixed step: CCD, move, walls, broadphase, narrowphase.
+    void step(float dt);
+    // Heap bytes held by the store, grid and solver scratch.
+    std::size_t memoryBytes() const;
+
+private:
+    // Step stages, in order
+    void sweepFastBodies(float dt);
+    float integrate(float dt); // returns the largest radius
+    void findCandidatePairs(float maxR);
+    void solveContacts();
+
+    template <class Integrator, class Drag, class Walls>
+    float integrateWith(float dt);
+    float inverseMass(int i) const { return sleep.asleep(i) ? 0.f : balls.invMass[i]; }
+    void wakeTouched();
+    bool touching(const BodyPair& pair) const;
+    void resolveContact(const BodyPair& pair);
+    void solveColoured();
+
+    TaskGraph stages; // CCD -> Integrate -> Broadphase -> Solve -> Sleep
+    float stepDt = 0.f, stepMaxR = 0.f;
+
+    SpatialGrid grid;
+    std::vector<BodyPair> pairs;
+    std::vector<BodyPair> contactPairs; // touching pairs of the sequential solver
+    std::vector<int> sweepCandidates;
+    // Touching pairs of the coloured solver, grouped so no two pairs of one
+    // colour share a body; the rest of its scratch lives on the step arena
+    std::vector<BodyPair> colouredPairs;
+    std::vector<float> slotMaxR;
+};
+
+void runCollisionSimulation();
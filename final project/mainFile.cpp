@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 #include <memory>
+#include "headless.h"
+#include "replay.h"
 
 // ANSI Colors
 #define RESET   "\033[0m"
@@ -14,17 +16,7 @@
 #define MAGENTA "\033[35m"
 #define BOLD    "\033[1m"
 
-static constexpr float PI = 3.14159265f;
-static constexpr float TIME_SCALE = 5.f;
-static constexpr float ORBIT_GRAVITY = 0.1f;
-static constexpr float PROJECTILE_GRAVITY = 500.f;
-
-class Simulation {
-public:
-    virtual void run() = 0;
-    virtual ~Simulation() = default;
-};
-
+// Each builds its scene and hands it to runSimulation() (simulation.h)
 void runOrbitSimulation();
 void runProjectileSimulation();
 void runCollisionSimulation();
@@ -46,7 +38,19 @@ void printMenu() {
     std::cout << CYAN << " Enter choice: " << RESET;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // "--replay file.rec" plays a recording; any other arguments select
+    // headless batch mode instead of the menu
+    if (argc == 3 && std::string(argv[1]) == "--replay") {
+        runReplayViewer(argv[2]);
+        return 0;
+    }
+    if (argc > 1) {
+        HeadlessOptions opts;
+        if (!parseHeadlessArgs(argc, argv, opts)) return 1;
+        return runHeadless(opts);
+    }
+
     while (true) {
         printMenu();
         int choice;
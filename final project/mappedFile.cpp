@@ -0,0 +1,191 @@
+#include "mappedFile.h"
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::openRead(const std::string& path) {
+    close();
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    LARGE_INTEGER bytes;
+    if (!GetFileSizeEx(file, &bytes) || bytes.QuadPart == 0) {
+        close();
+        return false;
+    }
+    writable = false;
+    if (!map(static_cast<std::size_t>(bytes.QuadPart))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::create(const std::string& path, std::size_t capacity) {
+    close();
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        return false;
+    }
+    writable = true;
+    if (!map(std::max<std::size_t>(capacity, 4096))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map(std::size_t bytes) {
+    // A writable mapping larger than the file extends it and allocates its
+    // clusters, failing with ERROR_DISK_FULL when they are not there
+    const DWORD protect = writable ? PAGE_READWRITE : PAGE_READONLY;
+    const unsigned long long size = bytes;
+    HANDLE grown = CreateFileMappingA(file, nullptr, protect, DWORD(size >> 32), DWORD(size & 0xffffffffu), nullptr);
+    if (!grown) {
+        full = GetLastError() == ERROR_DISK_FULL;
+        return false;
+    }
+    void* view = MapViewOfFile(grown, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, bytes);
+    if (!view) {
+        CloseHandle(grown);
+        return false;
+    }
+    unmap();
+    mapping = grown;
+    base = static_cast<std::uint8_t*>(view);
+    mapped = bytes;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (base) UnmapViewOfFile(base);
+    if (mapping) CloseHandle(mapping);
+    base = nullptr;
+    mapping = nullptr;
+    mapped = 0;
+}
+
+void MappedFile::close(std::size_t usedBytes) {
+    const bool trim = writable && base && usedBytes > 0;
+    unmap();
+    if (file) {
+        if (trim) {
+            LARGE_INTEGER end;
+            end.QuadPart = static_cast<LONGLONG>(usedBytes);
+            SetFilePointerEx(file, end, nullptr, FILE_BEGIN);
+            SetEndOfFile(file);
+        }
+        CloseHandle(file);
+        file = nullptr;
+    }
+    writable = false;
+}
+
+#else
+
+bool MappedFile::openRead(const std::string& path) {
+    close();
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close();
+        return false;
+    }
+    writable = false;
+    if (!map(static_cast<std::size_t>(st.st_size))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::create(const std::string& path, std::size_t capacity) {
+    close();
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    writable = true;
+    if (!map(std::max<std::size_t>(capacity, 4096))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::map(std::size_t bytes) {
+    if (writable && bytes > mapped) {
+        // ftruncate alone leaves a sparse tail, and writing into it on a
+        // full disk raises SIGBUS; allocate the blocks while we can still
+        // report it
+#if defined(__linux__)
+        const int rc = posix_fallocate(fd, static_cast<off_t>(mapped), static_cast<off_t>(bytes - mapped));
+        const bool allocated = rc == 0
+            || ((rc == EOPNOTSUPP || rc == EINVAL) && ftruncate(fd, static_cast<off_t>(bytes)) == 0);
+        full = rc == ENOSPC;
+#else
+        const bool allocated = ftruncate(fd, static_cast<off_t>(bytes)) == 0;
+        full = !allocated && errno == ENOSPC;
+#endif
+        if (!allocated) return false;
+    }
+    void* view = mmap(nullptr, bytes, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    if (view == MAP_FAILED) return false;
+    unmap();
+    base = static_cast<std::uint8_t*>(view);
+    mapped = bytes;
+    return true;
+}
+
+void MappedFile::unmap() {
+    if (base) munmap(base, mapped);
+    base = nullptr;
+    mapped = 0;
+}
+
+void MappedFile::close(std::size_t usedBytes) {
+    const bool trim = writable && base && usedBytes > 0;
+    unmap();
+    if (fd >= 0) {
+        if (trim) {
+            // On failure the file keeps its padding, which readers ignore
+            const int rc = ftruncate(fd, static_cast<off_t>(usedBytes));
+            (void)rc;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    writable = false;
+}
+
+#endif
+
+bool MappedFile::reserve(std::size_t n) {
+    if (!writable || !base) return false;
+    if (n <= mapped) return true;
+    // Double so long recordings remap only a few dozen times
+    std::size_t grown = mapped;
+    while (grown < n) grown *= 2;
+    full = false;
+    return map(grown);
+}
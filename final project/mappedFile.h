@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A file mapped into memory, read-only or growable for writing. Writers
+// append through reserve()/data() and call close() to trim the file to the
+// bytes actually used. Growing allocates the file's blocks up front, so a
+// full disk fails reserve() instead of faulting on a write through data().
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool openRead(const std::string& path);
+    // Creates or truncates path, mapped with an initial capacity.
+    bool create(const std::string& path, std::size_t capacity = 1 << 20);
+    // Grows the mapping (writers only) to hold at least n bytes; data()
+    // may move. On failure the old mapping and its contents stay valid.
+    bool reserve(std::size_t n);
+    // Whether the last failed reserve() ran out of disk space.
+    bool diskFull() const { return full; }
+    // Unmaps; a writer's file is cut to usedBytes first when given.
+    void close(std::size_t usedBytes = 0);
+
+    bool isOpen() const { return base != nullptr; }
+    std::uint8_t* data() { return base; }
+    const std::uint8_t* data() const { return base; }
+    std::size_t size() const { return mapped; }
+
+private:
+    // Maps the first `bytes` of the file, growing a writer's file to that
+    // size first; replaces the current view only once the new one exists.
+    bool map(std::size_t bytes);
+    void unmap();
+
+    std::uint8_t* base = nullptr;
+    std::size_t mapped = 0;
+    bool writable = false;
+    bool full = false;
+#if defined(_WIN32)
+    void* file = nullptr;    // HANDLE
+    void* mapping = nullptr; // HANDLE
+#else
+    int fd = -1;
+#endif
+};
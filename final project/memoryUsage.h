@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Heap bytes reserved by a vector, for the per-body memory reports.
+template <class T>
+std::size_t capacityBytes(const std::vector<T>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+template <class T, class... Rest>
+std::size_t capacityBytes(const std::vector<T>& v, const Rest&... rest) {
+    return capacityBytes(v) + capacityBytes(rest...);
+}
@@ -0,0 +1,182 @@
+#include "nbody.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "solarSystem.h"
+#include "gpuForces.h"
+#include "jobSystem.h"
+#include "profiler.h"
+#include "sceneConfig.h"
+
+int NBodyWorld::addBody(double px, double py, double pvx, double pvy, float m, float radius) {
+    int i = bodies.add(static_cast<float>(px), static_cast<float>(py), radius, m > 0.f ? 1.f / m : 0.f);
+    bodies.vx[i] = static_cast<float>(pvx);
+    bodies.vy[i] = static_cast<float>(pvy);
+    x.push_back(px);
+    y.push_back(py);
+    vx.push_back(pvx);
+    vy.push_back(pvy);
+    mass.push_back(m);
+    ax.push_back(0.f);
+    ay.push_back(0.f);
+    forcesReady = treeCurrent = false;
+    return i;
+}
+
+int NBodyWorld::addOrbiting(int centre, float orbitRadius, double angle, float m, float radius) {
+    const double speed = std::sqrt((double(mass[centre]) + m) / orbitRadius);
+    const double c = std::cos(angle), s = std::sin(angle);
+    return addBody(
+        x[centre] + orbitRadius * c, y[centre] + orbitRadius * s,
+        vx[centre] - speed * s, vy[centre] + speed * c,
+        m, radius);
+}
+
+void NBodyWorld::computeForces() {
+    const int count = (int)bodies.size();
+    forceX.resize(count);
+    forceY.resize(count);
+    for (int i = 0; i < count; ++i) {
+        forceX[i] = static_cast<float>(x[i]);
+        forceY[i] = static_cast<float>(y[i]);
+    }
+    const float eps2 = softening * softening;
+    if (gpu && gpu->ready()) {
+        ProfileZone zone("GPU forces");
+        if (gpu->compute(forceX.data(), forceY.data(), mass.data(), count, eps2, ax.data(), ay.data())) {
+            forcesReady = true;
+            treeCurrent = false;
+            return;
+        }
+    }
+    if (directSum) {
+        ProfileZone zone("Direct forces");
+        // The shader's sum, term for term; the body's own term is zero
+        auto range = [&](int, int b, int e) {
+            for (int i = b; i < e; ++i) {
+                float sx = 0.f, sy = 0.f;
+                for (int j = 0; j < count; ++j) {
+                    const float dx = forceX[j] - forceX[i], dy = forceY[j] - forceY[i];
+                    const float r2 = dx * dx + dy * dy + eps2;
+                    const float inv = r2 > 0.f ? 1.f / std::sqrt(r2) : 0.f;
+                    const float s = mass[j] * inv * inv * inv;
+                    sx += dx * s;
+                    sy += dy * s;
+                }
+                ax[i] = sx;
+                ay[i] = sy;
+            }
+        };
+        if (pool)
+            pool->parallelFor(0, count, range, 64);
+        else
+            range(0, 0, count);
+        forcesReady = true;
+        treeCurrent = false;
+        return;
+    }
+    ProfileZone phase("Tree build");
+    tree.build(forceX.data(), forceY.data(), mass.data(), count);
+    treeCurrent = true;
+    phase.next("Forces");
+    auto range = [&](int, int b, int e) {
+        for (int i = b; i < e; ++i)
+            tree.accel(forceX[i], forceY[i], i, theta, eps2, ax[i], ay[i]);
+    };
+    if (pool)
+        pool->parallelFor(0, count, range, 512);
+    else
+        range(0, 0, count);
+    forcesReady = true;
+}
+
+void NBodyWorld::step(float dt) {
+    withIntegrator(integrator, [&](auto policy) { step<decltype(policy)>(dt); });
+}
+
+void NBodyWorld::kick(float h) {
+    const int count = (int)bodies.size();
+    for (int i = 0; i < count; ++i) {
+        vx[i] += double(ax[i]) * h;
+        vy[i] += double(ay[i]) * h;
+    }
+}
+
+void NBodyWorld::drift(float h) {
+    const int count = (int)bodies.size();
+    for (int i = 0; i < count; ++i) {
+        x[i] += vx[i] * h;
+        y[i] += vy[i] * h;
+    }
+    forcesReady = false;
+}
+
+void NBodyWorld::syncBodies() {
+    const int count = (int)bodies.size();
+    double fastest2 = 0.0;
+    for (int i = 0; i < count; ++i) {
+        bodies.x[i] = static_cast<float>(x[i]);
+        bodies.y[i] = static_cast<float>(y[i]);
+        bodies.vx[i] = static_cast<float>(vx[i]);
+        bodies.vy[i] = static_cast<float>(vy[i]);
+        fastest2 = std::max(fastest2, vx[i] * vx[i] + vy[i] * vy[i]);
+    }
+    fastest = static_cast<float>(std::sqrt(fastest2));
+}
+
+double NBodyWorld::totalEnergy() const {
+    const int count = (int)bodies.size();
+    const double eps2 = double(softening) * softening;
+    double kinetic = 0.0, potential = 0.0;
+    for (int i = 0; i < count; ++i) {
+        if (mass[i] <= 0.f) continue;
+        kinetic += 0.5 * mass[i] * (vx[i] * vx[i] + vy[i] * vy[i]);
+        for (int j = i + 1; j < count; ++j) {
+            if (mass[j] <= 0.f) continue;
+            double dx = x[j] - x[i], dy = y[j] - y[i];
+            potential -= double(mass[i]) * mass[j] / std::sqrt(dx * dx + dy * dy + eps2);
+        }
+    }
+    return kinetic + potential;
+}
+
+NBodyWorld makeSolarNBody(int asteroids, unsigned seed) {
+    const float gmSun = sunGravitationalParameter();
+    const auto planets = makePlanets();
+    const float au = planets[2].orbitRadius;
+
+    NBodyWorld world;
+    world.bodies.reserve(1 + planets.size() + asteroids);
+    world.addBody(0.f, 0.f, 0.f, 0.f, gmSun, 60.f);
+    for (const auto& p : planets)
+        world.addOrbiting(0, p.orbitRadius, p.currentOrbitAngle, p.massRatio * gmSun, p.radius);
+
+    // Belt bodies share a total of ~1/1000 Earth mass, enough to exercise the tree
+    std::mt19937 rng{ seed };
+    std::uniform_real_distribution<float> radius(2.2f * au, 3.3f * au);
+    std::uniform_real_distribution<float> angle(0.f, TWO_PI);
+    const float each = asteroids > 0 ? 3e-9f * gmSun / asteroids : 0.f;
+    for (int i = 0; i < asteroids; ++i) {
+        float r = radius(rng);
+        world.addOrbiting(0, r, angle(rng), each, 1.f);
+    }
+
+    // Put the system's centre of mass at rest at the origin
+    double m = 0.0, px = 0.0, py = 0.0, cx = 0.0, cy = 0.0;
+    for (std::size_t i = 0; i < world.mass.size(); ++i) {
+        m += world.mass[i];
+        px += world.mass[i] * world.vx[i];
+        py += world.mass[i] * world.vy[i];
+        cx += world.mass[i] * world.x[i];
+        cy += world.mass[i] * world.y[i];
+    }
+    for (std::size_t i = 0; i < world.mass.size(); ++i) {
+        world.vx[i] -= px / m;
+        world.vy[i] -= py / m;
+        world.x[i] -= cx / m;
+        world.y[i] -= cy / m;
+    }
+    world.syncBodies();
+    world.bodies.savePrevious();
+    return world;
+}
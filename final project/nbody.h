@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "particleStore.h"
+#include "barnesHut.h"
+#include "integrators.h"
+
+class GpuNBodyForces;
+class JobSystem;
+
+// Gravitational N-body system in orbit-view pixels and seconds, with G = 1
+// (masses are gravitational parameters). Forces come from a Barnes-Hut tree
+// rebuilt every step, or from an exact direct sum: on the GPU when `gpu` is
+// set, else on the CPU when `directSum` is. Body 0 is the sun, then the
+// planets, then test particles.
+//
+// The state is integrated in double: at Neptune's 4500 px a float position
+// resolves only ~0.0005 px, about what a body moves in a 240 Hz step, so
+// float drift/kick rounding would swamp any integrator error. Forces only
+// need float, so the tree is built from a float copy of the positions, and
+// `bodies` is a float mirror for rendering, recording and reports,
+// refreshed at the end of every step.
+struct NBodyWorld {
+    std::vector<double> x, y, vx, vy; // physics state, relative to the view centre
+    ParticleStore bodies;             // float mirror of the above; read-only outside
+    std::vector<float> mass;
+    std::vector<float> ax, ay;
+    float theta = 0.5f;          // opening angle; 0 = exact O(n^2)
+    float softening = 1.f;       // px
+    IntegratorKind integrator = IntegratorKind::VelocityVerlet;
+    JobSystem* pool = nullptr;
+    GpuNBodyForces* gpu = nullptr; // used when ready; the tree stands in if it fails
+    bool directSum = false;        // exact O(n^2) on the CPU, the GPU's algorithm
+
+    int addBody(double px, double py, double pvx, double pvy, float m, float radius);
+    // Circular orbit around body `centre` (counter-clockwise in world space).
+    int addOrbiting(int centre, float orbitRadius, double angle, float m, float radius);
+
+    void computeForces();
+    // One step with the selected integrator.
+    void step(float dt);
+    template <class Integrator>
+    void step(float dt) {
+        Integrator::step(*this, dt);
+        syncBodies();
+    }
+
+    // Integrator interface (see integrators.h)
+    void computeAccel() { computeForces(); }
+    bool accelReady() const { return forcesReady; }
+    void kick(float h);
+    void drift(float h);
+
+    // Direct-sum total energy of the massive bodies (O(n^2), for diagnostics).
+    double totalEnergy() const;
+    std::size_t treeNodes() const { return tree.nodeCount(); }
+    // The tree the last forces came from, built from the positions of the
+    // last force evaluation; null before the first one or while they come
+    // from the GPU.
+    const BarnesHutTree* forceTree() const { return treeCurrent ? &tree : nullptr; }
+    // Fastest body at the last syncBodies(), px/s
+    float maxSpeed() const { return fastest; }
+    std::size_t memoryBytes() const {
+        return bodies.memoryBytes() + tree.memoryBytes()
+            + capacityBytes(x, y, vx, vy) + capacityBytes(mass, ax, ay, forceX, forceY);
+    }
+    // Rewrites the float mirror from the double state; call after changing
+    // the state from outside.
+    void syncBodies();
+
+private:
+    BarnesHutTree tree;
+    std::vector<float> forceX, forceY; // positions the tree was built from
+    bool forcesReady = false;
+    bool treeCurrent = false;
+    float fastest = 0.f;
+};
+
+// Sun and the eight planets on circular orbits whose periods match the
+// kinematic orbit view, plus `asteroids` belt bodies between 2.2 and 3.3 AU.
+NBodyWorld makeSolarNBody(int asteroids, unsigned seed);
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "memoryUsage.h"
+
+// Struct-of-arrays particle state shared by the simulations. Physics loops
+// integrate against these contiguous arrays; rendering reads them once per
+// frame instead of keeping state inside sf::CircleShape.
+struct ParticleStore {
+    std::vector<float> x, y;
+    std::vector<float> prevX, prevY; // state before the last step, for render interpolation
+    std::vector<float> vx, vy;
+    std::vector<float> radius;
+    std::vector<float> invMass; // 0 = immovable
+
+    std::size_t size() const { return x.size(); }
+
+    void reserve(std::size_t n) {
+        x.reserve(n); y.reserve(n);
+        prevX.reserve(n); prevY.reserve(n);
+        vx.reserve(n); vy.reserve(n);
+        radius.reserve(n); invMass.reserve(n);
+    }
+
+    void clear() {
+        x.clear(); y.clear();
+        prevX.clear(); prevY.clear();
+        vx.clear(); vy.clear();
+        radius.clear(); invMass.clear();
+    }
+
+    int add(float px, float py, float r, float inverseMass = 1.f) {
+        x.push_back(px); y.push_back(py);
+        prevX.push_back(px); prevY.push_back(py);
+        vx.push_back(0.f); vy.push_back(0.f);
+        radius.push_back(r);
+        invMass.push_back(inverseMass);
+        return static_cast<int>(x.size()) - 1;
+    }
+
+    // Call before each fixed step so rendering can blend old and new state.
+    void savePrevious() {
+        prevX = x;
+        prevY = y;
+    }
+
+    float renderX(std::size_t i, float alpha) const { return prevX[i] + (x[i] - prevX[i]) * alpha; }
+    float renderY(std::size_t i, float alpha) const { return prevY[i] + (y[i] - prevY[i]) * alpha; }
+
+    std::size_t memoryBytes() const {
+        return capacityBytes(x, y, prevX, prevY, vx, vy, radius, invMass);
+    }
+};
@@ -0,0 +1,210 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include "heapCounter.h"
+#include "jobSystem.h"
+
+Profiler::Profiler()
+    : events(MAX_EVENTS), owner(std::this_thread::get_id())
+{
+    frameZone = zoneId("Frame");
+}
+
+void Profiler::beginFrame() {
+    if (!onOwnerThread()) return;
+    const std::int64_t now = nowUs();
+    if (frameStart >= 0) {
+        record(frameZone, frameStart, now);
+        const std::size_t slot = frames % HISTORY;
+        for (auto& z : zones) {
+            z.history[slot] = z.current;
+            z.current = 0;
+        }
+        ++frames;
+    }
+    frameStart = now;
+}
+
+int Profiler::zoneId(const char* name) {
+    for (std::size_t i = 0; i < zones.size(); ++i) {
+        if (zones[i].name == name || std::strcmp(zones[i].name, name) == 0)
+            return static_cast<int>(i);
+    }
+    zones.push_back({ name, std::vector<std::int64_t>(HISTORY, 0) });
+    return static_cast<int>(zones.size() - 1);
+}
+
+void Profiler::record(int zone, std::int64_t beginUs, std::int64_t endUs) {
+    zones[zone].current += endUs - beginUs;
+    events[eventHead] = { zone, beginUs, endUs };
+    eventHead = (eventHead + 1) % MAX_EVENTS;
+    eventCount = std::min(eventCount + 1, MAX_EVENTS);
+}
+
+Profiler::Stats Profiler::stats(int zone) const {
+    Stats s;
+    const std::size_t n = storedFrames();
+    if (n == 0) return s;
+    std::vector<std::int64_t> samples(zones[zone].history.begin(), zones[zone].history.begin() + n);
+    double sum = 0.0;
+    for (auto us : samples) sum += static_cast<double>(us);
+    const std::size_t p99 = (n * 99) / 100;
+    std::nth_element(samples.begin(), samples.begin() + p99, samples.end());
+    s.p99Ms = samples[p99] / 1000.0;
+    s.minMs = *std::min_element(samples.begin(), samples.end()) / 1000.0;
+    s.avgMs = sum / n / 1000.0;
+    return s;
+}
+
+void Profiler::addSteps(int count, std::uint64_t heapAllocations) {
+    steps.fetch_add(static_cast<std::uint64_t>(count), std::memory_order_relaxed);
+    stepAllocations.fetch_add(heapAllocations, std::memory_order_relaxed);
+}
+
+std::string Profiler::summary() const {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << std::left << std::setw(14) << "zone (ms)" << std::right
+        << std::setw(8) << "avg" << std::setw(8) << "min" << std::setw(8) << "p99" << "\n";
+    for (std::size_t i = 0; i < zones.size(); ++i) {
+        const Stats s = stats(static_cast<int>(i));
+        ss << std::left << std::setw(14) << zones[i].name << std::right
+            << std::setw(8) << s.avgMs << std::setw(8) << s.minMs << std::setw(8) << s.p99Ms << "\n";
+    }
+    return ss.str();
+}
+
+bool Profiler::writeCsv(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "frame";
+    for (const auto& z : zones) out << ',' << z.name;
+    out << '\n';
+    const std::size_t n = storedFrames();
+    for (std::size_t f = frames - n; f < frames; ++f) {
+        out << f;
+        for (const auto& z : zones) out << ',' << z.history[f % HISTORY];
+        out << '\n';
+    }
+    return true;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\"traceEvents\":[\n";
+    const std::size_t first = (eventHead + MAX_EVENTS - eventCount) % MAX_EVENTS;
+    for (std::size_t i = 0; i < eventCount; ++i) {
+        const Event& e = events[(first + i) % MAX_EVENTS];
+        out << (i ? ",\n" : "") << "{\"name\":\"" << zones[e.zone].name
+            << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << e.beginUs
+            << ",\"dur\":" << e.endUs - e.beginUs << '}';
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+ProfileZone::ProfileZone(const char* name)
+    : zone(profiler().onOwnerThread() ? profiler().zoneId(name) : -1), beginUs(profiler().nowUs())
+{
+}
+
+ProfileZone::~ProfileZone() {
+    if (zone >= 0) profiler().record(zone, beginUs, profiler().nowUs());
+}
+
+void ProfileZone::next(const char* name) {
+    if (zone < 0) return;
+    const std::int64_t now = profiler().nowUs();
+    profiler().record(zone, beginUs, now);
+    zone = profiler().zoneId(name);
+    beginUs = now;
+}
+
+ProfilerOverlay::ProfilerOverlay(const sf::Font& font, const JobSystem* jobSystem) : jobs(jobSystem) {
+    text.setFont(font);
+    text.setCharacterSize(13);
+    text.setFillColor(sf::Color(180, 255, 180));
+    text.setPosition(5.f, 5.f);
+    background.setFillColor(sf::Color(0, 0, 0, 180));
+}
+
+void ProfilerOverlay::handleEvent(const sf::Event& event) {
+    if (event.type != sf::Event::KeyPressed) return;
+    if (event.key.code == sf::Keyboard::F3) {
+        visible = !visible;
+        framesUntilRefresh = 0;
+    }
+    if (event.key.code == sf::Keyboard::F4) {
+        if (profiler().writeCsv("profile.csv") && profiler().writeChromeTrace("profile.json"))
+            std::cout << "Wrote profile.csv and profile.json\n";
+        else
+            std::cerr << "Failed to write profile files\n";
+    }
+}
+
+void ProfilerOverlay::update() {
+    ++framesSinceRefresh;
+    if (!visible || framesUntilRefresh-- > 0) return;
+    framesUntilRefresh = 15;
+    text.setString(profiler().summary() + heapSummary() + jobSummary());
+    framesSinceRefresh = 0;
+    const sf::FloatRect box = text.getLocalBounds();
+    background.setSize({ box.left + box.width + 10.f, box.top + box.height + 10.f });
+}
+
+std::string ProfilerOverlay::heapSummary() {
+    // Whole process per frame; stepping only per step
+    const std::uint64_t heap = heapAllocations();
+    const std::uint64_t steps = profiler().stepsRun(), stepHeap = profiler().stepHeapAllocations();
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << "Heap allocs "
+        << double(heap - lastHeap) / std::max(1, framesSinceRefresh) << "/frame "
+        << double(stepHeap - lastStepHeap) / std::max<std::uint64_t>(1, steps - lastSteps) << "/step\n";
+    lastHeap = heap;
+    lastSteps = steps;
+    lastStepHeap = stepHeap;
+    return out.str();
+}
+
+std::string ProfilerOverlay::jobSummary() {
+    if (!jobs) return "";
+    // Busy share of each thread's wall time since the previous refresh
+    const double wallMs = sinceRefresh.restart().asMicroseconds() / 1000.0;
+    const int threads = jobs->size();
+    lastBusyMs.resize(threads, 0.0);
+    std::ostringstream out;
+    out << "Threads";
+    std::uint64_t steals = 0;
+    for (int t = 0; t < threads; ++t) {
+        const JobSystem::ThreadStats s = jobs->threadStats(t);
+        const double busy = s.busyMs - lastBusyMs[t];
+        lastBusyMs[t] = s.busyMs;
+        steals += s.steals;
+        out << ' ' << std::lround(wallMs > 0.0 ? 100.0 * std::min(1.0, busy / wallMs) : 0.0) << '%';
+    }
+    out << "  steals " << steals - lastSteals << '\n';
+    lastSteals = steals;
+    return out.str();
+}
+
+void ProfilerOverlay::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (!visible) return;
+    // Top-right corner in screen space, whatever view the scene left active
+    const sf::View scene = target.getView();
+    target.setView(target.getDefaultView());
+    states.transform.translate(target.getSize().x - background.getSize().x - 5.f, 5.f);
+    target.draw(background, states);
+    target.draw(text, states);
+    target.setView(scene);
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+class JobSystem;
+
+// Lightweight frame profiler. Zones are timed with RAII ProfileZone objects,
+// summed per frame and kept for the last HISTORY frames (min/avg/p99), and
+// every zone entry is also logged to a ring of events for Chrome's
+// about://tracing. Zone names must be string literals. The profiler belongs
+// to the thread that first used it; zones opened on other threads (pool
+// workers stepping their share of a scene) are ignored.
+class Profiler {
+public:
+    static constexpr std::size_t HISTORY = 300;      // frames of per-zone totals
+    static constexpr std::size_t MAX_EVENTS = 1 << 16;
+
+    struct Stats {
+        double minMs = 0.0, avgMs = 0.0, p99Ms = 0.0;
+    };
+
+    Profiler();
+
+    // Closes the current frame (recorded as zone "Frame") and starts the next.
+    // Ignored off the owner thread, like its zones.
+    void beginFrame();
+
+    int zoneId(const char* name);
+    void record(int zone, std::int64_t beginUs, std::int64_t endUs);
+    std::int64_t nowUs() const { return clock.getElapsedTime().asMicroseconds(); }
+    bool onOwnerThread() const { return std::this_thread::get_id() == owner; }
+
+    std::size_t zoneCount() const { return zones.size(); }
+    const char* zoneName(int zone) const { return zones[zone].name; }
+    Stats stats(int zone) const;
+
+    // Fixed steps run and the heap allocations made while running them. Fed
+    // by whichever thread steps, so safe to call off the owner thread.
+    void addSteps(int steps, std::uint64_t heapAllocations);
+    std::uint64_t stepsRun() const { return steps.load(std::memory_order_relaxed); }
+    std::uint64_t stepHeapAllocations() const { return stepAllocations.load(std::memory_order_relaxed); }
+
+    // One line per zone: name, avg, min and p99 in milliseconds.
+    std::string summary() const;
+    // Per-frame zone totals (microseconds), oldest frame first.
+    bool writeCsv(const std::string& path) const;
+    // Logged zone entries in Chrome trace event format.
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    struct Zone {
+        const char* name;
+        std::vector<std::int64_t> history; // HISTORY slots, indexed by frame
+        std::int64_t current = 0;          // total in the open frame
+    };
+    struct Event {
+        int zone;
+        std::int64_t beginUs, endUs;
+    };
+
+    std::size_t storedFrames() const { return frames < HISTORY ? frames : HISTORY; }
+
+    std::vector<Zone> zones;
+    std::vector<Event> events;
+    std::size_t eventHead = 0, eventCount = 0;
+    std::size_t frames = 0;
+    std::int64_t frameStart = -1;
+    int frameZone;
+    sf::Clock clock;
+    std::thread::id owner;
+    std::atomic<std::uint64_t> steps{ 0 }, stepAllocations{ 0 };
+};
+
+// Process-wide profiler, created on first use.
+Profiler& profiler();
+
+// Times its scope into a zone. next() closes the current zone and opens
+// another, for consecutive phases of a loop body.
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* name);
+    ~ProfileZone();
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+    void next(const char* name);
+
+private:
+    int zone;
+    std::int64_t beginUs;
+};
+
+// Profiler summary in the top-right corner of the window. F3 toggles it, F4 writes
+// profile.csv and profile.json next to the executable. It also shows heap
+// allocations per frame and per step, and given a job system how busy each
+// of its threads was since the last refresh.
+class ProfilerOverlay : public sf::Drawable {
+public:
+    explicit ProfilerOverlay(const sf::Font& font, const JobSystem* jobSystem = nullptr);
+
+    void handleEvent(const sf::Event& event);
+    // Refreshes the text a few times a second; call once per frame.
+    void update();
+
+    bool visible = false;
+
+private:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+    std::string heapSummary();
+    std::string jobSummary();
+
+    const JobSystem* jobs;
+    std::vector<double> lastBusyMs; // per thread, at the previous refresh
+    std::uint64_t lastSteals = 0;
+    std::uint64_t lastHeap = 0, lastSteps = 0, lastStepHeap = 0;
+    int framesSinceRefresh = 0;
+    sf::Clock sinceRefresh;
+    sf::Text text;
+    sf::RectangleShape background;
+    int framesUntilRefresh = 0;
+};
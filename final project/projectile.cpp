@@ -1,82 +1,349 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <sstream>
+#include "projectile.h"
+#include "assets.h"
+#include "circleBatch.h"
+#include "fixedStep.h"
+#include "integrators.h"
+#include "simdKernels.h"
+#include "simulation.h"
+#include "jobSystem.h"
 
-static constexpr float PI = 3.14159265f;
-static constexpr float PROJECTILE_GRAVITY = 500.f;
+static constexpr int PREVIEW_DOTS = 20;         // one every PREVIEW_SPACING seconds of flight
+static constexpr float PREVIEW_SPACING = 0.1f;
+static constexpr int SWEEP_SHELLS = 4096;
+static constexpr float SWEEP_LINEAR_DRAG = 0.5f;      // 1/s
+static constexpr float SWEEP_QUADRATIC_DRAG = 0.001f; // 1/px
 
-void runProjectileSimulation() {
-    const sf::Vector2u windowSize{ 800, 600 };
-
-    sf::RenderWindow window(
-        sf::VideoMode(windowSize.x, windowSize.y),
-        "Projectile Motion"
-    );
-    window.setFramerateLimit(60);
-
-    // Ground
-    constexpr float groundH = 4.f;
-    sf::RectangleShape ground({ float(windowSize.x), groundH });
-    ground.setPosition(0.f, windowSize.y - groundH);
-    ground.setFillColor({ 50, 200, 50 });
-
-    // Cannon
-    const sf::Vector2f cannonPos{ 50.f, windowSize.y - groundH - 10.f };
-    sf::RectangleShape cannon({ 50.f, 20.f });
-    cannon.setOrigin(0.f, 10.f);
-    cannon.setPosition(cannonPos);
-    cannon.setFillColor(sf::Color::Blue);
-
-    // Ball
-    constexpr float ballR = 8.f;
-    sf::CircleShape ball(ballR);
-    ball.setOrigin(ballR, ballR);
-    ball.setFillColor(sf::Color::Red);
-    ball.setPosition(cannonPos);
-
-    // State flags
-    bool aiming = false, launched = false, peakPause = false, landed = false;
-
-    // Physics variables
-    sf::Vector2f velocity{ 0.f, 0.f };
-    float prevVy = 0.f;
-    float maxHeight = 0.f, range = 0.f, projAngle = 0.f, maxVel = 0.f;
-
-    // Trajectory preview
-    std::vector<sf::CircleShape> traj;
-
-    // Clocks
-    sf::Clock clock, pauseClock, resultClock;
-    const float peakPauseDur = 2.f;
-
-    // Font & result text
-    sf::Font font;
-    font.loadFromFile("OpenSans-Regular.ttf");
-    sf::Text results;
-    results.setFont(font);
-    results.setCharacterSize(18);
-    results.setFillColor(sf::Color::White);
-    results.setPosition(200.f, 50.f);
-
-    while (window.isOpen()) {
-        // Event handling
-        sf::Event e;
-        while (window.pollEvent(e)) {
-            if (e.type == sf::Event::Closed)
-                window.close();
+namespace {
+    // The shell as an integrator system. Gravity is constant, so velocity
+    // Verlet lands exactly on the analytic parabola.
+    struct ShellSystem {
+        sf::Vector2f& position;
+        sf::Vector2f& velocity;
+
+        void computeAccel() {}
+        bool accelReady() const { return true; }
+        void kick(float h) { velocity.y += GRAVITY * h; }
+        void drift(float h) { position += velocity * h; }
+    };
+    using ShellIntegrator = VelocityVerlet;
+}
+
+sf::Vector2f shellPositionAt(sf::Vector2f from, sf::Vector2f v, float t) {
+    return from + v * t + sf::Vector2f(0.f, 0.5f * GRAVITY * t * t);
+}
+
+float shellLandingTime(sf::Vector2f from, sf::Vector2f v, float groundY) {
+    // Later root of from.y + v.y t + g t^2 / 2 = groundY
+    const float drop = groundY - from.y;
+    if (drop < 0.f) return 0.f;
+    return (-v.y + std::sqrt(v.y * v.y + 2.f * GRAVITY * drop)) / GRAVITY;
+}
+
+const char* dragModelName(DragModel model) {
+    switch (model) {
+    case DragModel::Linear: return "linear drag";
+    case DragModel::Quadratic: return "quadratic drag";
+    default: return "vacuum";
+    }
+}
+
+namespace {
+    // Cubic Hermite through a step's start (p0, v0) and end (p1, v1) over a
+    // step of length h, and its time derivative, at s in [0, 1].
+    float hermite(float p0, float v0, float p1, float v1, float h, float s) {
+        const float s2 = s * s, s3 = s2 * s;
+        return (2.f * s3 - 3.f * s2 + 1.f) * p0 + (s3 - 2.f * s2 + s) * h * v0
+            + (3.f * s2 - 2.f * s3) * p1 + (s3 - s2) * h * v1;
+    }
+
+    float hermiteSlope(float p0, float v0, float p1, float v1, float h, float s) {
+        const float s2 = s * s;
+        return (6.f * s2 - 6.f * s) * (p0 - p1) / h + (3.f * s2 - 4.f * s + 1.f) * v0 + (3.f * s2 - 2.f * s) * v1;
+    }
+
+    // Root of f in [0, 1] when f(0) and f(1) differ in sign; float precision
+    // is reached well within the iteration count.
+    template <class F>
+    float bisect(F f) {
+        float lo = 0.f, hi = 1.f;
+        const bool negLo = f(0.f) < 0.f;
+        for (int it = 0; it < 32; ++it) {
+            const float mid = 0.5f * (lo + hi);
+            if ((f(mid) < 0.f) == negLo) lo = mid;
+            else hi = mid;
+        }
+        return 0.5f * (lo + hi);
+    }
+
+    // Landing x of a shell under linear drag k, from the closed-form
+    // trajectory, solved in double precision.
+    double linearDragLandingX(sf::Vector2f from, sf::Vector2f v, float k, float groundY) {
+        const double g = GRAVITY, vt = g / k;
+        auto y = [&](double t) { return from.y + vt * t + (v.y - vt) * (1.0 - std::exp(-k * t)) / k; };
+        // y falls monotonically after the apex, so bracket from there
+        double lo = v.y < 0.f ? std::log((vt - v.y) / vt) / k : 0.0;
+        double hi = std::max(lo, 1e-3);
+        while (y(hi) < groundY) hi *= 2.0;
+        for (int it = 0; it < 100; ++it) {
+            const double mid = 0.5 * (lo + hi);
+            if (y(mid) < groundY) lo = mid;
+            else hi = mid;
+        }
+        const double t = 0.5 * (lo + hi);
+        return from.x + v.x * (1.0 - std::exp(-k * t)) / k;
+    }
+}
+
+void ProjectileWorld::reset() {
+    position = prevPosition = origin;
+    velocity = { 0.f, 0.f };
+    prevVy = 0.f;
+    launched = landed = false;
+}
+
+void ProjectileWorld::launch(sf::Vector2f from, sf::Vector2f v) {
+    position = prevPosition = from;
+    velocity = v;
+    prevVy = v.y;
+    maxHeight = range = 0.f;
+    launched = true;
+    landed = false;
+}
+
+bool ProjectileWorld::step(float dt) {
+    prevPosition = position;
+    if (!launched || landed) return false;
+
+    ShellSystem shell{ position, velocity };
+    ShellIntegrator::step(shell, dt);
+
+    // Detect peak
+    if (velocity.y >= 0.f && prevVy < 0.f) {
+        maxHeight = origin.y - position.y;
+        velocity.y = 0.f;
+        prevVy = 0.f;
+        return true;
+    }
+    prevVy = velocity.y;
+
+    // Detect landing
+    if (position.y >= groundY) {
+        position.y = groundY;
+        landed = true;
+        range = position.x - origin.x;
+    }
+    return false;
+}
+
+void ShellBatch::launchSweep(int count, float minAngle, float maxAngle, float minSpeed, float maxSpeed) {
+    // Angles x speeds on a near-square grid, angle varying fastest
+    const int angles = std::max(1, (int)std::ceil(std::sqrt((float)count)));
+    const int speeds = std::max(1, (count + angles - 1) / angles);
+    shells.clear();
+    shells.reserve(count);
+    angle.resize(count);
+    speed.resize(count);
+    maxHeight.assign(count, 0.f);
+    range.assign(count, 0.f);
+    flightTime.assign(count, 0.f);
+    landed.assign(count, 0);
+    prevVx.resize(count);
+    prevVy.resize(count);
+    landedCount = 0;
+    time = 0.f;
+    for (int i = 0; i < count; ++i) {
+        const int a = i % angles, s = i / angles;
+        angle[i] = angles > 1 ? minAngle + (maxAngle - minAngle) * a / (angles - 1) : minAngle;
+        speed[i] = speeds > 1 ? minSpeed + (maxSpeed - minSpeed) * s / (speeds - 1) : minSpeed;
+        const float rad = angle[i] * PI / 180.f;
+        shells.add(origin.x, origin.y, 2.f);
+        shells.vx[i] = speed[i] * std::cos(rad);
+        shells.vy[i] = -speed[i] * std::sin(rad);
+    }
+}
+
+template <class Drag>
+void ShellBatch::stepRange(int begin, int end, float dt) {
+    std::copy(shells.x.begin() + begin, shells.x.begin() + end, shells.prevX.begin() + begin);
+    std::copy(shells.y.begin() + begin, shells.y.begin() + end, shells.prevY.begin() + begin);
+    std::copy(shells.vx.begin() + begin, shells.vx.begin() + end, prevVx.begin() + begin);
+    std::copy(shells.vy.begin() + begin, shells.vy.begin() + end, prevVy.begin() + begin);
+
+    if constexpr (Drag::MODEL == DragModel::None) {
+        // Integrate each run of shells still in flight as one slice
+        for (int i = begin; i < end;) {
+            if (landed[i]) { ++i; continue; }
+            int j = i;
+            while (j < end && !landed[j]) ++j;
+            UniformFieldSystem flight{ shells, i, j, 0.f, GRAVITY };
+            ShellIntegrator::step(flight, dt);
+            i = j;
+        }
+    }
+    else {
+        simdKernels().dragFlightRk4<Drag>()(shells.x.data(), shells.y.data(), shells.vx.data(), shells.vy.data(),
+            landed.data(), begin, end, drag, GRAVITY, dt);
+    }
+
+    for (int i = begin; i < end; ++i)
+        if (!landed[i]) findEvents(i, dt);
+}
+
+void ShellBatch::findEvents(int i, float dt) {
+    const float x0 = shells.prevX[i], y0 = shells.prevY[i], vx0 = prevVx[i], vy0 = prevVy[i];
+    const float x1 = shells.x[i], y1 = shells.y[i], vx1 = shells.vx[i], vy1 = shells.vy[i];
+
+    // Peak: vertical velocity turns from up (negative) to down inside the step
+    if (vy0 < 0.f && vy1 >= 0.f) {
+        const float s = bisect([&](float t) { return hermiteSlope(y0, vy0, y1, vy1, dt, t); });
+        maxHeight[i] = origin.y - hermite(y0, vy0, y1, vy1, dt, s);
+    }
+
+    // Landing: the cubic crosses the ground on the way down
+    if (y0 < groundY && y1 >= groundY) {
+        const float s = bisect([&](float t) { return hermite(y0, vy0, y1, vy1, dt, t) - groundY; });
+        shells.x[i] = hermite(x0, vx0, x1, vx1, dt, s);
+        shells.y[i] = groundY;
+        shells.vx[i] = shells.vy[i] = 0.f;
+        range[i] = shells.x[i] - origin.x;
+        flightTime[i] = time + s * dt;
+        landed[i] = 1;
+    }
+}
+
+void ShellBatch::step(float dt) {
+    const int count = (int)shells.size();
+    withDragModel(dragModel, [&](auto policy) {
+        using Drag = decltype(policy);
+        if (pool) pool->parallelFor(0, count, [&](int, int b, int e) { stepRange<Drag>(b, e, dt); }, 1024);
+        else stepRange<Drag>(0, count, dt);
+    });
+    time += dt;
+    landedCount = (std::size_t)std::count(landed.begin(), landed.end(), 1);
+}
+
+ShellBatch::Stats ShellBatch::stats() const {
+    Stats s;
+    double sumRange = 0.0, sumHeight = 0.0;
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < shells.size(); ++i) {
+        if (!landed[i]) continue;
+        if (n == 0) {
+            s.minRange = s.maxRange = range[i];
+            s.minHeight = s.maxHeight = maxHeight[i];
+            s.bestAngle = angle[i];
+            s.bestSpeed = speed[i];
+        }
+        s.minRange = std::min(s.minRange, range[i]);
+        s.minHeight = std::min(s.minHeight, maxHeight[i]);
+        s.maxHeight = std::max(s.maxHeight, maxHeight[i]);
+        if (range[i] > s.maxRange) {
+            s.maxRange = range[i];
+            s.bestAngle = angle[i];
+            s.bestSpeed = speed[i];
+        }
+        if (dragModel == DragModel::Quadratic) {
+            s.maxRangeError = -1.f;
+        }
+        else {
+            const float rad = angle[i] * PI / 180.f;
+            const sf::Vector2f v(speed[i] * std::cos(rad), -speed[i] * std::sin(rad));
+            const double exact = dragModel == DragModel::Linear && drag > 0.f
+                ? linearDragLandingX(origin, v, drag, groundY) - origin.x
+                : v.x * shellLandingTime(origin, v, groundY);
+            s.maxRangeError = std::max(s.maxRangeError, (float)std::abs(range[i] - exact));
+        }
+        sumRange += range[i];
+        sumHeight += maxHeight[i];
+        ++n;
+    }
+    if (n) {
+        s.meanRange = (float)(sumRange / n);
+        s.meanHeight = (float)(sumHeight / n);
+    }
+    return s;
+}
+
+namespace {
+    class ProjectileScene : public Simulation {
+    public:
+        WindowSettings windowSettings() const override {
+            return { sf::VideoMode(WIDTH, HEIGHT), "Projectile Motion" };
+        }
+
+        void start(sf::RenderWindow&, JobSystem& pool) override {
+            // Ground
+            ground.setSize({ float(WIDTH), GROUND_H });
+            ground.setPosition(0.f, HEIGHT - GROUND_H);
+            ground.setFillColor({ 50, 200, 50 });
+
+            // Cannon
+            cannon.setSize({ 50.f, 20.f });
+            cannon.setOrigin(0.f, 10.f);
+            cannon.setPosition(cannonPos);
+            cannon.setFillColor(sf::Color::Blue);
+
+            // Ball
+            ball.setRadius(BALL_R);
+            ball.setOrigin(BALL_R, BALL_R);
+            ball.setFillColor(sf::Color::Red);
+            ball.setPosition(cannonPos);
+
+            // Physics; the shape is only placed at render time
+            shell.origin = cannonPos;
+            shell.groundY = HEIGHT - BALL_R;
+            shell.reset();
+
+            // Trajectory preview: a fixed set of dots, moved in closed form only
+            // when the aim changes. Dots past the window collapse to nothing.
+            for (int i = 0; i < PREVIEW_DOTS; ++i) traj.add(0.f, 0.f, 0.f, sf::Color::White);
+            traj.upload();
+
+            // B fires a sweep of shells over angles and speeds and reports
+            // statistics; D cycles the drag model it flies under
+            sweep.origin = cannonPos;
+            sweep.groundY = shell.groundY;
+            sweep.pool = &pool;
+            sweepDots.reserve(SWEEP_SHELLS);
+
+            // Result text
+            results.setFont(assets().font("OpenSans-Regular.ttf"));
+            results.setCharacterSize(18);
+            results.setFillColor(sf::Color::White);
+            results.setPosition(200.f, 50.f);
+        }
+
+        void handleEvent(const sf::Event& e, sf::RenderWindow& window) override {
+            if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::D && !sweeping) {
+                sweep.dragModel = static_cast<DragModel>(((int)sweep.dragModel + 1) % 3);
+                sweep.drag = sweep.dragModel == DragModel::Linear ? SWEEP_LINEAR_DRAG : SWEEP_QUADRATIC_DRAG;
+                results.setString(std::string("Sweep: ") + dragModelName(sweep.dragModel));
+                resultClock.restart();
+            }
+            if (e.type == sf::Event::KeyPressed && e.key.code == sf::Keyboard::B && !aiming) {
+                sweep.launchSweep(SWEEP_SHELLS, 5.f, 85.f, 200.f, 600.f); // longest shot just fits the window
+                sweepDots.clear();
+                for (std::size_t i = 0; i < sweep.shells.size(); ++i)
+                    sweepDots.add(sweep.shells.x[i], sweep.shells.y[i], 2.f, sf::Color(255, 160, 60));
+                sweeping = true;
+                results.setString("");
+            }
 
             // Begin aiming
             if (e.type == sf::Event::MouseButtonPressed &&
                 e.mouseButton.button == sf::Mouse::Left &&
-                !launched)
+                !shell.launched)
             {
                 aiming = true;
-                traj.clear();
-                ball.setPosition(cannonPos);
+                hidePreview();
+                shell.reset();
                 results.setString("");
-                landed = launched = false;
             }
 
             // Launch
@@ -85,7 +352,6 @@ void runProjectileSimulation() {
                 aiming)
             {
                 aiming = false;
-                launched = true;
 
                 sf::Vector2f mp = window.mapPixelToCoords(
                     { e.mouseButton.x, e.mouseButton.y }
@@ -95,71 +361,32 @@ void runProjectileSimulation() {
                 if (len > 0.f) {
                     dir /= len;
                     float speed = std::min(len * 4.f, 1000.f);
-                    velocity = dir * speed;
                     maxVel = speed;
-                    projAngle = std::atan2(-dir.y, dir.x) * 180.f / PI;
-                    ball.setPosition(cannonPos + dir * 50.f);
+                    projAngle = std::atan2(-dir.y, dir.x) * RAD_TO_DEG;
+                    shell.launch(cannonPos + dir * 50.f, dir * speed);
                 }
             }
         }
 
-        float dt = clock.restart().asSeconds();
-
-        // Draw trajectory while aiming
-        if (aiming) {
-            sf::Vector2f mp = window.mapPixelToCoords(
-                sf::Mouse::getPosition(window)
-            );
-            sf::Vector2f dir = mp - cannonPos;
-            float len = std::hypot(dir.x, dir.y);
-            if (len > 0.f) {
-                dir /= len;
-                sf::Vector2f v0 = dir * std::min(len * 4.f, 1000.f);
-                traj.clear();
-                for (float t = 0.f; t < 2.f; t += 0.1f) {
-                    sf::Vector2f p = cannonPos + dir * 50.f
-                        + v0 * t
-                        + sf::Vector2f(0.f, 0.5f * PROJECTILE_GRAVITY * t * t);
-                    if (p.y > windowSize.y) break;
-                    sf::CircleShape dot(2.f);
-                    dot.setOrigin(2.f, 2.f);
-                    dot.setPosition(p);
-                    dot.setFillColor(sf::Color::White);
-                    traj.push_back(dot);
-                }
-                cannon.setRotation(std::atan2(dir.y, dir.x) * 180.f / PI);
+        // Fixed steps, holding still at the peak
+        void step(float dt) override {
+            if (sweeping && !sweep.done()) {
+                sweep.step(dt);
+                if (sweep.done()) showSweepResults();
             }
-        }
-
-        // Update physics
-        if (launched && !peakPause && !landed) {
-            velocity.y += PROJECTILE_GRAVITY * dt;
-            ball.move(velocity * dt);
-
-            // Detect peak
-            if (velocity.y >= 0.f && prevVy < 0.f) {
+            if (peakPause) {
+                shell.prevPosition = shell.position;
+                return;
+            }
+            bool wasLanded = shell.landed;
+            if (shell.step(dt)) {
                 peakPause = true;
                 pauseClock.restart();
-                maxHeight = cannonPos.y - ball.getPosition().y;
-                velocity.y = 0.f;
             }
-            prevVy = velocity.y;
-        }
-        else if (peakPause) {
-            if (pauseClock.getElapsedTime().asSeconds() >= peakPauseDur)
-                peakPause = false;
-        }
-
-        // Detect landing
-        if (launched && !landed && !peakPause) {
-            if (ball.getPosition().y >= windowSize.y - ballR) {
-                ball.setPosition(ball.getPosition().x, windowSize.y - ballR);
-                landed = true;
-                range = ball.getPosition().x - cannonPos.x;
-
+            if (shell.landed && !wasLanded) {
                 std::ostringstream ss;
-                ss << "Range: " << range << " px\n"
-                    << "Max Height: " << maxHeight << " px\n"
+                ss << "Range: " << shell.range << " px\n"
+                    << "Max Height: " << shell.maxHeight << " px\n"
                     << "Angle: " << projAngle << " deg\n"
                     << "Max Velocity: " << maxVel << " px/s";
                 results.setString(ss.str());
@@ -167,22 +394,112 @@ void runProjectileSimulation() {
             }
         }
 
-        // Hide results after 2s and allow rethrow
-        if (landed &&
-            resultClock.getElapsedTime().asSeconds() >= 4.f)
-        {
-            landed = launched = false;
-            results.setString("");
-            ball.setPosition(cannonPos);
+        void update(sf::RenderWindow& window, const FrameInfo&) override {
+            // Re-place the trajectory preview when the aim moves
+            const sf::Vector2i mouse = sf::Mouse::getPosition(window);
+            if (aiming && mouse != previewAim) {
+                previewAim = mouse;
+                sf::Vector2f dir = window.mapPixelToCoords(mouse) - cannonPos;
+                float len = std::hypot(dir.x, dir.y);
+                if (len > 0.f) {
+                    dir /= len;
+                    const sf::Vector2f v0 = dir * std::min(len * 4.f, 1000.f);
+                    const sf::Vector2f muzzle = cannonPos + dir * 50.f;
+                    for (int i = 0; i < PREVIEW_DOTS; ++i) {
+                        const sf::Vector2f p = shellPositionAt(muzzle, v0, i * PREVIEW_SPACING);
+                        traj.set(i, p.x, p.y, p.y > HEIGHT ? 0.f : 2.f);
+                    }
+                    traj.upload();
+                    cannon.setRotation(std::atan2(dir.y, dir.x) * RAD_TO_DEG);
+                }
+            }
+
+            if (peakPause) {
+                if (pauseClock.getElapsedTime().asSeconds() >= PEAK_PAUSE)
+                    peakPause = false;
+            }
+
+            // Hide results after 4s and allow rethrow
+            if (shell.landed &&
+                resultClock.getElapsedTime().asSeconds() >= 4.f)
+            {
+                shell.reset();
+                results.setString("");
+            }
+            // Sweep results and drag-model notes stay up a little longer
+            if (!sweeping && !shell.launched && !results.getString().isEmpty() &&
+                resultClock.getElapsedTime().asSeconds() >= 6.f)
+            {
+                sweepDots.clear();
+                results.setString("");
+            }
         }
 
-        // Render
-        window.clear(sf::Color::Black);
-        window.draw(ground);
-        window.draw(cannon);
-        for (auto& d : traj) window.draw(d);
-        window.draw(ball);
-        if (landed) window.draw(results);
-        window.display();
-    }
+        void render(sf::RenderWindow& window, const FrameInfo& frame) override {
+            const float alpha = frame.alpha;
+            ball.setPosition(lerp(shell.prevPosition.x, shell.position.x, alpha),
+                lerp(shell.prevPosition.y, shell.position.y, alpha));
+            window.draw(ground);
+            window.draw(cannon);
+            window.draw(traj);
+            if (sweepDots.size() > 0) {
+                for (std::size_t i = 0; i < sweep.shells.size(); ++i)
+                    sweepDots.set(i, sweep.shells.renderX(i, alpha), sweep.shells.renderY(i, alpha), 2.f);
+                sweepDots.upload();
+                window.draw(sweepDots);
+            }
+            window.draw(ball);
+            if (!results.getString().isEmpty()) window.draw(results);
+        }
+
+    private:
+        static constexpr unsigned WIDTH = 800, HEIGHT = 600;
+        static constexpr float GROUND_H = 4.f;
+        static constexpr float BALL_R = 8.f;
+        static constexpr float PEAK_PAUSE = 2.f; // seconds held at the top of the arc
+
+        void hidePreview() {
+            for (int i = 0; i < PREVIEW_DOTS; ++i) traj.set(i, 0.f, 0.f, 0.f);
+            traj.upload();
+            previewAim = { -1, -1 };
+        }
+
+        void showSweepResults() {
+            sweeping = false;
+            const ShellBatch::Stats st = sweep.stats();
+            std::ostringstream ss;
+            ss << sweep.shells.size() << " shells in " << dragModelName(sweep.dragModel) << ", " << sweep.angle.front() << "-" << sweep.angle.back()
+                << " deg, " << sweep.speed.front() << "-" << sweep.speed.back() << " px/s\n"
+                << "Range: " << st.minRange << " / " << st.meanRange << " / " << st.maxRange << " px (min/mean/max)\n"
+                << "Max Height: " << st.minHeight << " / " << st.meanHeight << " / " << st.maxHeight << " px\n"
+                << "Longest: " << st.bestAngle << " deg at " << st.bestSpeed << " px/s\n"
+                << "Flight: " << sweep.time << " s to the last landing";
+            if (st.maxRangeError >= 0.f) ss << "\nError vs closed form: " << st.maxRangeError << " px";
+            results.setString(ss.str());
+            resultClock.restart();
+        }
+
+        const sf::Vector2f cannonPos{ 50.f, HEIGHT - GROUND_H - 10.f };
+        sf::RectangleShape ground, cannon;
+        sf::CircleShape ball;
+
+        ProjectileWorld shell;
+        bool aiming = false, peakPause = false;
+        float projAngle = 0.f, maxVel = 0.f;
+
+        CircleBatch traj{ sf::VertexBuffer::Dynamic };
+        sf::Vector2i previewAim{ -1, -1 };
+
+        ShellBatch sweep;
+        CircleBatch sweepDots;
+        bool sweeping = false;
+
+        sf::Clock pauseClock, resultClock;
+        sf::Text results;
+    };
+}
+
+void runProjectileSimulation() {
+    ProjectileScene scene;
+    runSimulation(scene);
 }
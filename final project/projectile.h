@@ -0,0 +1,81 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+#include "particleStore.h"
+#include "sceneConfig.h"
+
+class JobSystem;
+
+// Closed-form flight of a shell launched from `from` with velocity v.
+sf::Vector2f shellPositionAt(sf::Vector2f from, sf::Vector2f v, float t);
+// Time at which that shell comes down through groundY; 0 if it starts below.
+float shellLandingTime(sf::Vector2f from, sf::Vector2f v, float groundY);
+
+// One cannon shell under gravity, with peak and landing detection.
+struct ProjectileWorld {
+    sf::Vector2f origin;  // heights and range are measured from here
+    float groundY = 0.f;  // shell centre y when it touches the ground
+
+    sf::Vector2f position, prevPosition, velocity;
+    bool launched = false, landed = false;
+    float maxHeight = 0.f, range = 0.f;
+
+    void reset();
+    void launch(sf::Vector2f from, sf::Vector2f v);
+    // One fixed step. Returns true on the step the shell passes its peak.
+    bool step(float dt);
+
+private:
+    float prevVy = 0.f;
+};
+
+// Many shells in flight at once for ballistics sweeps: angles and speeds on
+// a grid. In vacuum they are stepped with the same integrator as
+// ProjectileWorld; with drag by the vectorised RK4 flight kernel. Peaks and
+// landings are found by root-finding on the cubic through each step's start
+// and end states, so they do not snap to step boundaries. Storage is sized
+// once in launchSweep, so stepping thousands of shells never allocates.
+struct ShellBatch {
+    sf::Vector2f origin;  // heights and range are measured from here
+    float groundY = 0.f;
+    DragModel dragModel = DragModel::None;
+    float drag = 0.f;
+    JobSystem* pool = nullptr; // null steps on the calling thread
+
+    ParticleStore shells;
+    std::vector<float> angle, speed;      // launch parameters, degrees and px/s
+    std::vector<float> maxHeight, range;
+    std::vector<float> flightTime;        // seconds from launch to landing
+    std::vector<char> landed;
+    std::size_t landedCount = 0;
+    float time = 0.f;                     // since launch
+
+    struct Stats {
+        float minRange = 0.f, meanRange = 0.f, maxRange = 0.f;
+        float minHeight = 0.f, meanHeight = 0.f, maxHeight = 0.f;
+        float bestAngle = 0.f, bestSpeed = 0.f; // launch of the longest shot
+        // Largest |range - closed form|; -1 for quadratic drag, which has none
+        float maxRangeError = 0.f;
+    };
+
+    // count shells from origin, angles spread over [minAngle, maxAngle]
+    // and speeds over [minSpeed, maxSpeed].
+    void launchSweep(int count, float minAngle, float maxAngle, float minSpeed, float maxSpeed);
+    void step(float dt);
+    bool done() const { return landedCount == shells.size(); }
+    // Landed shells only.
+    Stats stats() const;
+    std::size_t memoryBytes() const {
+        return shells.memoryBytes() + capacityBytes(angle, speed, maxHeight, range, flightTime, landed, prevVx, prevVy);
+    }
+
+private:
+    template <class Drag>
+    void stepRange(int begin, int end, float dt);
+    void findEvents(int i, float dt);
+
+    std::vector<float> prevVx, prevVy; // velocity at the start of the step
+};
+
+void runProjectileSimulation();
@@ -0,0 +1,355 @@
+#include "replay.h"
+#include <SFML/Window.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include "assets.h"
+#include "circleBatch.h"
+#include "simulation.h"
+
+namespace {
+    constexpr std::uint32_t VERSION = 1;
+    constexpr float POS_SCALE = 256.f;
+    constexpr float VEL_SCALE = 16.f;
+    constexpr int VALUES = 4;             // x, y, vx, vy per body
+    constexpr std::size_t MAX_VARINT = 5; // bytes of a 32-bit varint
+
+    std::int32_t quantize(float v, float scale) {
+        // Clamped so frame-to-frame differences always fit in 32 bits
+        const float limit = 1073741823.f;
+        const float q = std::round(v * scale);
+        return static_cast<std::int32_t>(std::max(-limit, std::min(limit, q)));
+    }
+
+    std::uint32_t zigzag(std::int32_t v) {
+        return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+    }
+
+    std::int32_t unzigzag(std::uint32_t u) {
+        return static_cast<std::int32_t>((u >> 1) ^ (0u - (u & 1u)));
+    }
+
+    std::uint8_t* putVarint(std::uint8_t* out, std::uint32_t u) {
+        while (u >= 0x80) {
+            *out++ = static_cast<std::uint8_t>(u | 0x80);
+            u >>= 7;
+        }
+        *out++ = static_cast<std::uint8_t>(u);
+        return out;
+    }
+
+    // Returns nullptr on a truncated or malformed value.
+    const std::uint8_t* getVarint(const std::uint8_t* in, const std::uint8_t* end, std::uint32_t& u) {
+        u = 0;
+        for (int shift = 0; shift < 35 && in < end; shift += 7) {
+            const std::uint8_t b = *in++;
+            u |= static_cast<std::uint32_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) return in;
+        }
+        return nullptr;
+    }
+
+    std::uint64_t readOffset(const std::uint8_t* index, int f) {
+        std::uint64_t off;
+        std::memcpy(&off, index + std::size_t(f) * sizeof(off), sizeof(off));
+        return off;
+    }
+}
+
+unsigned sessionSeed() {
+    unsigned seed;
+    if (const char* env = std::getenv("PHYSICS_SEED")) seed = static_cast<unsigned>(std::strtoul(env, nullptr, 10));
+    else seed = std::random_device{}();
+    std::cout << "seed " << seed << "\n";
+    return seed;
+}
+
+bool ReplayRecorder::open(const std::string& path, const ParticleStore& p, float dt, unsigned seed,
+    sf::FloatRect bounds, int keyframeInterval) {
+    close();
+    const std::size_t bodies = p.size();
+    const std::size_t radiiBytes = bodies * sizeof(float);
+    if (!file.create(path, sizeof(ReplayHeader) + radiiBytes + bodies * VALUES * MAX_VARINT * 8)) {
+        std::cerr << "Failed to create " << path << "\n";
+        return false;
+    }
+    header = ReplayHeader{};
+    std::memcpy(header.magic, "PREC", 4);
+    header.version = VERSION;
+    header.bodies = static_cast<std::uint32_t>(bodies);
+    header.keyframeInterval = static_cast<std::uint32_t>(std::max(keyframeInterval, 1));
+    header.seed = seed;
+    header.dt = dt;
+    header.posScale = POS_SCALE;
+    header.velScale = VEL_SCALE;
+    header.bounds[0] = bounds.left;
+    header.bounds[1] = bounds.top;
+    header.bounds[2] = bounds.width;
+    header.bounds[3] = bounds.height;
+    std::memcpy(file.data(), &header, sizeof(header));
+    if (radiiBytes) std::memcpy(file.data() + sizeof(header), p.radius.data(), radiiBytes);
+    used = sizeof(header) + radiiBytes;
+    last.assign(bodies * VALUES, 0);
+    frameOffsets.clear();
+    return true;
+}
+
+bool ReplayRecorder::record(const ParticleStore& p) {
+    if (!file.isOpen() || p.size() != header.bodies) return false;
+    // Room for the index as well, counting this frame, so that close() never
+    // needs to grow the file and a recording cut short here still keeps
+    // every frame written so far
+    const std::size_t frameBytes = std::size_t(header.bodies) * VALUES * MAX_VARINT;
+    const std::size_t indexBytes = (frameOffsets.size() + 1) * sizeof(std::uint64_t);
+    if (!file.reserve(used + frameBytes + indexBytes)) {
+        std::cerr << "Recording stopped: " << (file.diskFull() ? "out of disk space" : "cannot grow the file") << "\n";
+        close();
+        return false;
+    }
+    // Keyframes hold the values themselves, the rest differences; starting
+    // from zeroes makes both the same loop
+    const bool keyframe = frameOffsets.size() % header.keyframeInterval == 0;
+    if (keyframe) std::fill(last.begin(), last.end(), 0);
+    frameOffsets.push_back(used);
+    std::uint8_t* out = file.data() + used;
+    for (std::size_t i = 0; i < header.bodies; ++i) {
+        const std::int32_t q[VALUES] = {
+            quantize(p.x[i], POS_SCALE), quantize(p.y[i], POS_SCALE),
+            quantize(p.vx[i], VEL_SCALE), quantize(p.vy[i], VEL_SCALE) };
+        std::int32_t* prev = &last[i * VALUES];
+        for (int k = 0; k < VALUES; ++k) {
+            out = putVarint(out, zigzag(q[k] - prev[k]));
+            prev[k] = q[k];
+        }
+    }
+    used = static_cast<std::size_t>(out - file.data());
+    return true;
+}
+
+bool ReplayRecorder::close() {
+    if (!file.isOpen()) return false;
+    const std::size_t indexBytes = frameOffsets.size() * sizeof(std::uint64_t);
+    const bool ok = file.reserve(used + indexBytes);
+    if (ok) {
+        if (indexBytes) std::memcpy(file.data() + used, frameOffsets.data(), indexBytes);
+        header.frameCount = static_cast<std::uint32_t>(frameOffsets.size());
+        header.indexOffset = used;
+        std::memcpy(file.data(), &header, sizeof(header));
+        used += indexBytes;
+    }
+    file.close(used);
+    return ok;
+}
+
+bool ReplayPlayer::open(const std::string& path) {
+    current = -1;
+    if (!file.openRead(path)) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    if (file.size() < sizeof(ReplayHeader)) {
+        std::cerr << path << ": not a recording\n";
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    const std::size_t radiiEnd = sizeof(header) + std::size_t(header.bodies) * sizeof(float);
+    if (std::memcmp(header.magic, "PREC", 4) != 0 || header.version != VERSION ||
+        header.keyframeInterval == 0 || radiiEnd > file.size()) {
+        std::cerr << path << ": not a recording\n";
+        return false;
+    }
+    if (header.indexOffset == 0 ||
+        header.indexOffset + std::uint64_t(header.frameCount) * sizeof(std::uint64_t) > file.size()) {
+        std::cerr << path << ": recording was not finished\n";
+        return false;
+    }
+    index = file.data() + header.indexOffset;
+    radii.resize(header.bodies);
+    if (header.bodies) std::memcpy(radii.data(), file.data() + sizeof(header), header.bodies * sizeof(float));
+    state.assign(std::size_t(header.bodies) * VALUES, 0);
+    return true;
+}
+
+bool ReplayPlayer::decode(int f) {
+    const std::uint64_t begin = readOffset(index, f);
+    const std::uint64_t end = f + 1 < frameCount() ? readOffset(index, f + 1) : header.indexOffset;
+    if (begin > end || end > header.indexOffset) return false;
+    if (f % header.keyframeInterval == 0) std::fill(state.begin(), state.end(), 0);
+    const std::uint8_t* in = file.data() + begin;
+    const std::uint8_t* stop = file.data() + end;
+    for (std::int32_t& v : state) {
+        std::uint32_t u;
+        in = getVarint(in, stop, u);
+        if (!in) return false;
+        // Wrapping add, so a corrupt delta cannot overflow
+        v = static_cast<std::int32_t>(static_cast<std::uint32_t>(v) + static_cast<std::uint32_t>(unzigzag(u)));
+    }
+    current = f;
+    return true;
+}
+
+bool ReplayPlayer::seek(int f, ParticleStore& p) {
+    if (!file.isOpen() || f < 0 || f >= frameCount()) return false;
+    const int interval = static_cast<int>(header.keyframeInterval);
+    const int keyframe = f - f % interval;
+    // Carry on from the current frame when it lies between the keyframe and f
+    int next = current >= keyframe && current <= f ? current + 1 : keyframe;
+    for (; next <= f; ++next) {
+        if (!decode(next)) {
+            current = -1;
+            return false;
+        }
+    }
+
+    const std::size_t n = header.bodies;
+    if (p.size() != n) {
+        p.clear();
+        p.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) p.add(0.f, 0.f, radii[i]);
+    }
+    const float invPos = 1.f / header.posScale, invVel = 1.f / header.velScale;
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::int32_t* q = &state[i * VALUES];
+        p.x[i] = q[0] * invPos;
+        p.y[i] = q[1] * invPos;
+        p.vx[i] = q[2] * invVel;
+        p.vy[i] = q[3] * invVel;
+    }
+    return true;
+}
+
+namespace {
+    // Plays frames back by wall-clock time; nothing is simulated, so step()
+    // does no work and the frame to show is picked in update().
+    class ReplayScene : public Simulation {
+    public:
+        ReplayScene(ReplayPlayer& p, const std::string& file) : player(p), path(file) {}
+
+        WindowSettings windowSettings() const override {
+            return { sf::VideoMode(1000, 800), "Replay - " + path };
+        }
+
+        void start(sf::RenderWindow& window, JobSystem&) override {
+            // Scene fitted into the window above the scrub bar
+            const sf::FloatRect bounds = player.bounds();
+            win = sf::Vector2f(float(window.getSize().x), float(window.getSize().y));
+            const float scale = std::min(win.x / (bounds.width * 1.05f), (win.y - BAR_H) / (bounds.height * 1.05f));
+            sceneView = sf::View(sf::Vector2f(bounds.left + bounds.width / 2.f, bounds.top + bounds.height / 2.f + BAR_H / (2.f * scale)),
+                sf::Vector2f(win.x / scale, win.y / scale));
+
+            container.setSize({ bounds.width, bounds.height });
+            container.setPosition(bounds.left, bounds.top);
+            container.setFillColor(sf::Color::Transparent);
+            container.setOutlineColor(sf::Color::White);
+            container.setOutlineThickness(2.f / scale);
+
+            bar.setSize({ win.x - 20.f, 8.f });
+            bar.setPosition(10.f, win.y - BAR_H / 2.f - 4.f);
+            bar.setFillColor(sf::Color(80, 80, 80));
+            cursor.setSize({ 4.f, 20.f });
+            cursor.setFillColor(sf::Color::White);
+            status.setFont(assets().font("OpenSans-Regular.ttf"));
+            status.setCharacterSize(14);
+            status.setFillColor(sf::Color::White);
+            status.setPosition(10.f, 10.f);
+
+            player.seek(0, balls);
+            for (std::size_t i = 0; i < balls.size(); ++i)
+                batch.add(balls.x[i], balls.y[i], balls.radius[i], sf::Color(100, 200, 250));
+            length = player.frameCount() * double(player.dt());
+        }
+
+        void handleEvent(const sf::Event& e, sf::RenderWindow&) override {
+            if (e.type == sf::Event::KeyPressed) {
+                const double frame = player.dt();
+                switch (e.key.code) {
+                case sf::Keyboard::Space: playing = !playing; break;
+                case sf::Keyboard::Right: t += playing ? 1.0 : frame; break;
+                case sf::Keyboard::Left: t -= playing ? 1.0 : frame; break;
+                case sf::Keyboard::Home: t = 0.0; break;
+                case sf::Keyboard::End: t = length; break;
+                case sf::Keyboard::Add: case sf::Keyboard::Equal: speed = std::min(speed * 2.f, 64.f); break;
+                case sf::Keyboard::Subtract: case sf::Keyboard::Hyphen: speed = std::max(speed / 2.f, 1.f / 16.f); break;
+                default: break;
+                }
+            }
+            if (e.type == sf::Event::MouseButtonPressed && e.mouseButton.button == sf::Mouse::Left &&
+                e.mouseButton.y > win.y - BAR_H) {
+                scrubbing = true;
+                scrubTo(e.mouseButton.x);
+            }
+            if (e.type == sf::Event::MouseMoved && scrubbing) scrubTo(e.mouseMove.x);
+            if (e.type == sf::Event::MouseButtonReleased && e.mouseButton.button == sf::Mouse::Left)
+                scrubbing = false;
+        }
+
+        void step(float) override {}
+
+        void update(sf::RenderWindow&, const FrameInfo& frame) override {
+            if (playing && !scrubbing) t += frame.seconds * speed;
+            t = std::min(std::max(t, 0.0), length);
+            const int f = std::min(player.frameCount() - 1, int(t / player.dt()));
+            if (f != player.frame() && !player.seek(f, balls)) {
+                std::cerr << path << ": frame " << f << " is corrupt\n";
+                playing = false;
+            }
+
+            for (std::size_t i = 0; i < balls.size(); ++i)
+                batch.set(i, balls.x[i], balls.y[i], balls.radius[i]);
+            batch.upload();
+            std::ostringstream ss;
+            ss.precision(2);
+            ss << std::fixed << (playing ? "playing " : "paused ") << t << " / " << length << " s  x" << speed
+                << "  frame " << player.frame() + 1 << "/" << player.frameCount()
+                << "\nSpace play/pause, arrows step, +/- speed, drag the bar to scrub";
+            status.setString(ss.str());
+            cursor.setPosition(bar.getPosition().x + bar.getSize().x * float(t / std::max(length, 1e-9)) - 2.f,
+                bar.getPosition().y - 6.f);
+        }
+
+        void render(sf::RenderWindow& window, const FrameInfo&) override {
+            window.setView(sceneView);
+            window.draw(container);
+            window.draw(batch);
+            window.setView(window.getDefaultView());
+            window.draw(bar);
+            window.draw(cursor);
+            window.draw(status);
+        }
+
+    private:
+        static constexpr float BAR_H = 40.f;
+
+        void scrubTo(int mouseX) {
+            const float f = (mouseX - bar.getPosition().x) / bar.getSize().x;
+            t = std::min(std::max(f, 0.f), 1.f) * length;
+        }
+
+        ReplayPlayer& player;
+        std::string path;
+        sf::Vector2f win;
+        sf::View sceneView;
+        sf::RectangleShape container, bar, cursor;
+        sf::Text status;
+        ParticleStore balls;
+        CircleBatch batch;
+
+        // Playback time in recording seconds; frames are picked from it, never simulated
+        double t = 0.0, length = 0.0;
+        float speed = 1.f;
+        bool playing = true, scrubbing = false;
+    };
+}
+
+void runReplayViewer(const std::string& path) {
+    ReplayPlayer player;
+    if (!player.open(path) || player.frameCount() == 0) return;
+    std::cout << path << ": " << player.frameCount() << " frames of " << player.bodyCount()
+        << " bodies, seed " << player.seed() << "\n";
+    ReplayScene scene(player, path);
+    runSimulation(scene);
+}
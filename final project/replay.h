@@ -0,0 +1,92 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mappedFile.h"
+#include "particleStore.h"
+
+// Recordings (.rec) hold one frame per fixed step for a scene with a fixed
+// body count. Positions are quantized to 1/256 px and velocities to
+// 1/16 px/s; every keyframeInterval frames a keyframe stores the quantized
+// values, and the frames between store per-body differences from the
+// previous frame. Each value is zigzag varint encoded, which puts a resting
+// body in 4 bytes per frame. A frame index at the end lets players seek to
+// any frame by decoding forward from the keyframe before it.
+//
+// Layout (little endian): ReplayHeader, the radius of every body as float,
+// the frames, then frameCount 64-bit frame offsets at header.indexOffset.
+struct ReplayHeader {
+    char magic[4];                 // "PREC"
+    std::uint32_t version;
+    std::uint32_t bodies;
+    std::uint32_t keyframeInterval;
+    std::uint32_t seed;            // scene seed, so the run can be re-simulated
+    std::uint32_t frameCount;      // written by close()
+    std::uint64_t indexOffset;     // written by close(); 0 = unfinished recording
+    float dt;
+    float posScale, velScale;      // quantization steps per px and per px/s
+    float bounds[4];               // left, top, width, height of the scene
+    std::uint32_t reserved;
+};
+static_assert(sizeof(ReplayHeader) == 64, "ReplayHeader is part of the file format");
+
+// Seed for interactive scenes: PHYSICS_SEED from the environment when set,
+// otherwise a random one. Printed either way so a run can be repeated.
+unsigned sessionSeed();
+
+// Streams frames into a memory-mapped file.
+class ReplayRecorder {
+public:
+    ~ReplayRecorder() { close(); }
+
+    bool open(const std::string& path, const ParticleStore& p, float dt, unsigned seed,
+        sf::FloatRect bounds, int keyframeInterval = 240);
+    // Appends the state after one step. The body count must not change.
+    bool record(const ParticleStore& p);
+    // Writes the frame index and trims the file; safe to call twice.
+    bool close();
+
+    bool isOpen() const { return file.isOpen(); }
+    std::size_t frameCount() const { return frameOffsets.size(); }
+    std::size_t bytesWritten() const { return used; }
+
+private:
+    MappedFile file;
+    ReplayHeader header{};
+    std::vector<std::int32_t> last; // quantized x, y, vx, vy of the previous frame
+    std::vector<std::uint64_t> frameOffsets;
+    std::size_t used = 0;
+};
+
+// Decodes frames of a finished recording straight from the mapped file.
+class ReplayPlayer {
+public:
+    bool open(const std::string& path);
+
+    int frameCount() const { return (int)header.frameCount; }
+    std::size_t bodyCount() const { return header.bodies; }
+    float dt() const { return header.dt; }
+    unsigned seed() const { return header.seed; }
+    sf::FloatRect bounds() const { return { header.bounds[0], header.bounds[1], header.bounds[2], header.bounds[3] }; }
+    int frame() const { return current; }
+
+    // Fills p (resized to the body count) with frame f. Stepping forward
+    // within a keyframe interval decodes only the frames in between; other
+    // jumps restart from the keyframe at or before f.
+    bool seek(int f, ParticleStore& p);
+
+private:
+    bool decode(int f);
+
+    MappedFile file;
+    ReplayHeader header{};
+    const std::uint8_t* index = nullptr;
+    std::vector<float> radii;
+    std::vector<std::int32_t> state; // quantized x, y, vx, vy of frame current
+    int current = -1;
+};
+
+// Window that plays a recording back in real time with a scrub bar.
+void runReplayViewer(const std::string& path);
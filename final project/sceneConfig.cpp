@@ -0,0 +1,72 @@
+#include "sceneConfig.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    // A whole number in [0, last], as the enum keys take
+    bool choice(float value, int last, int& out) {
+        if (value < 0.f || value > float(last) || value != std::floor(value)) return false;
+        out = static_cast<int>(value);
+        return true;
+    }
+}
+
+bool SceneConfig::isKey(const std::string& key) {
+    return key == "integrator" || key == "drag_model" || key == "drag" || key == "gravity"
+        || key == "walls" || key == "restitution";
+}
+
+bool SceneConfig::set(const std::string& key, float value) {
+    int n = 0;
+    if (key == "integrator") {
+        if (!choice(value, (int)IntegratorKind::Yoshida4, n)) return false;
+        integrator = static_cast<IntegratorKind>(n);
+    }
+    else if (key == "drag_model") {
+        if (!choice(value, (int)DragModel::Quadratic, n)) return false;
+        dragModel = static_cast<DragModel>(n);
+    }
+    else if (key == "walls") {
+        if (!choice(value, (int)WallMode::Open, n)) return false;
+        walls = static_cast<WallMode>(n);
+    }
+    else if (key == "drag") {
+        if (!(value >= 0.f)) return false;
+        drag = value;
+    }
+    else if (key == "restitution") {
+        if (!(value >= 0.f)) return false;
+        restitution = value;
+    }
+    else if (key == "gravity") {
+        if (std::isnan(value)) return false;
+        gravity = value;
+    }
+    else return false;
+    return true;
+}
+
+bool loadSceneConfig(const std::string& path, SceneConfig& config) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        const auto eq = line.find('=');
+        const std::string key = eq == std::string::npos ? line : line.substr(0, eq);
+        std::istringstream number(eq == std::string::npos ? std::string() : line.substr(eq + 1));
+        float value = 0.f;
+        if (!(number >> value) || !config.set(key, value)) {
+            std::cerr << path << ":" << lineNo << ": expected key=value with a key of "
+                "integrator, drag_model, drag, gravity, walls or restitution\n";
+            return false;
+        }
+    }
+    return true;
+}
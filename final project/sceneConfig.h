@@ -0,0 +1,114 @@
+#pragma once
+#include <cmath>
+#include <string>
+#include "integrators.h"
+
+// Constants shared by the scenes, and compile-time policies for the parts
+// of their hot loops a scene configures at runtime. A runtime choice (a key
+// press, a --param, a SceneConfig file) becomes a policy type once per step
+// through a with*() helper, as withIntegrator() in integrators.h does for
+// integrators, so the per-body loops are prebuilt specialisations with the
+// choice folded in.
+
+constexpr float PI = 3.14159265358979323846f;
+constexpr float TWO_PI = 2.f * PI;
+// For angles accumulated over long runs
+constexpr double TWO_PI_DOUBLE = 6.283185307179586;
+constexpr float DEG_TO_RAD = PI / 180.f;
+constexpr float RAD_TO_DEG = 180.f / PI;
+
+// Downward acceleration of the projectile and fluid scenes, px/s^2
+constexpr float GRAVITY = 500.f;
+
+// Air resistance on a shell. Linear drag uses the same coefficient as a
+// fluid's viscosity (acceleration -k v, k in 1/s); quadratic drag is
+// -k |v| v with k in 1/px.
+enum class DragModel { None, Linear, Quadratic };
+const char* dragModelName(DragModel model);
+
+// Drag policies: coefficient() is c in a = g - c v for drag constant k.
+struct NoDrag {
+    static constexpr DragModel MODEL = DragModel::None;
+    static constexpr bool QUADRATIC = false;
+    static float coefficient(float, float, float) { return 0.f; }
+};
+
+struct LinearDrag {
+    static constexpr DragModel MODEL = DragModel::Linear;
+    static constexpr bool QUADRATIC = false;
+    static float coefficient(float, float, float k) { return k; }
+};
+
+struct QuadraticDrag {
+    static constexpr DragModel MODEL = DragModel::Quadratic;
+    static constexpr bool QUADRATIC = true;
+    static float coefficient(float vx, float vy, float k) { return k * std::sqrt(vx * vx + vy * vy); }
+};
+
+// Calls f(Drag{}) for a runtime choice.
+template <class F>
+void withDragModel(DragModel model, F&& f) {
+    switch (model) {
+    case DragModel::None: f(NoDrag{}); break;
+    case DragModel::Linear: f(LinearDrag{}); break;
+    case DragModel::Quadratic: f(QuadraticDrag{}); break;
+    }
+}
+
+// The container of a collision world. Box clamps and reflects at all four
+// walls of its bounds; Open has none, for clouds in free space, and the
+// bounds then only size the broadphase grid.
+enum class WallMode { Box, Open };
+
+// Wall policies
+struct BoxWalls {
+    static constexpr WallMode MODE = WallMode::Box;
+};
+
+struct OpenWalls {
+    static constexpr WallMode MODE = WallMode::Open;
+};
+
+// Calls f(Walls{}) for a runtime choice.
+template <class F>
+void withWallMode(WallMode mode, F&& f) {
+    switch (mode) {
+    case WallMode::Box: f(BoxWalls{}); break;
+    case WallMode::Open: f(OpenWalls{}); break;
+    }
+}
+
+// The physics of a collision world as data: what it integrates with, the
+// field its bodies fall through and what contains them. It can be read
+// from key=value pairs (--param, or a file for loadSceneConfig()) and is
+// turned into policy types once per step by withSceneConfig().
+struct SceneConfig {
+    IntegratorKind integrator = IntegratorKind::SemiImplicitEuler;
+    DragModel dragModel = DragModel::None;
+    float drag = 0.f;          // k of the drag model
+    float gravity = 0.f;       // downward, px/s^2
+    WallMode walls = WallMode::Box;
+    float restitution = 0.8f;  // of walls and contacts
+
+    // Keys: integrator (0-3, as IntegratorKind), drag_model (0-2), drag,
+    // gravity, walls (0 box, 1 open), restitution.
+    static bool isKey(const std::string& key);
+    // False, leaving the config alone, for an unknown key or a value out of range.
+    bool set(const std::string& key, float value);
+};
+
+// Applies "key=value" lines to config; blank lines and lines starting with #
+// are skipped. Prints the first bad line and returns false on any, or when
+// the file cannot be opened.
+bool loadSceneConfig(const std::string& path, SceneConfig& config);
+
+// Calls f(Integrator{}, Drag{}, Walls{}): one of the 4 x 3 x 2 prebuilt
+// specialisations, picked once for a step.
+template <class F>
+void withSceneConfig(const SceneConfig& config, F&& f) {
+    withIntegrator(config.integrator, [&](auto integrator) {
+        withDragModel(config.dragModel, [&](auto drag) {
+            withWallMode(config.walls, [&](auto walls) { f(integrator, drag, walls); });
+        });
+    });
+}
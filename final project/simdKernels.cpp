@@ -0,0 +1,401 @@
+#include "simdKernels.h"
+#include <cmath>
+#include "sceneConfig.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define KERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC compiles intrinsics for any target; GCC and Clang need the function
+// marked so AVX2 code can live next to the baseline build.
+#if defined(KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+namespace {
+    // ---- Scalar reference ----
+
+    inline void driftCollideWallsOne(float* x, float* y, float* vx, float* vy, const float* r,
+        int i, float dt, const WallBox& box) {
+        const float negE = -box.restitution;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+        if (x[i] - r[i] < box.left) { x[i] = box.left + r[i]; vx[i] *= negE; }
+        if (x[i] + r[i] > box.right) { x[i] = box.right - r[i]; vx[i] *= negE; }
+        if (y[i] - r[i] < box.top) { y[i] = box.top + r[i]; vy[i] *= negE; }
+        if (y[i] + r[i] > box.bottom) { y[i] = box.bottom - r[i]; vy[i] *= negE; }
+    }
+
+    inline void dragFallOne(float* y, float* vy, const float* k, int i, float g, float dt) {
+        vy[i] += (g - k[i] * vy[i]) * dt;
+        y[i] += vy[i] * dt;
+    }
+
+    inline void kickWithDragOne(float* vx, float* vy, int i, float k, float g, float dt) {
+        vx[i] -= k * vx[i] * dt;
+        vy[i] += (g - k * vy[i]) * dt;
+    }
+
+    template <class Drag>
+    inline void dragAccel(float vx, float vy, float k, float g, float& ax, float& ay) {
+        const float c = Drag::coefficient(vx, vy, k);
+        ax = 0.f - c * vx;
+        ay = g - c * vy;
+    }
+
+    template <class Drag>
+    inline void dragFlightRk4One(float* x, float* y, float* vx, float* vy, int i,
+        float k, float g, float dt) {
+        const float h2 = dt * 0.5f, h6 = dt / 6.f;
+        const float u1 = vx[i], v1 = vy[i];
+        float ax1, ay1, ax2, ay2, ax3, ay3, ax4, ay4;
+        dragAccel<Drag>(u1, v1, k, g, ax1, ay1);
+        const float u2 = u1 + ax1 * h2, v2 = v1 + ay1 * h2;
+        dragAccel<Drag>(u2, v2, k, g, ax2, ay2);
+        const float u3 = u1 + ax2 * h2, v3 = v1 + ay2 * h2;
+        dragAccel<Drag>(u3, v3, k, g, ax3, ay3);
+        const float u4 = u1 + ax3 * dt, v4 = v1 + ay3 * dt;
+        dragAccel<Drag>(u4, v4, k, g, ax4, ay4);
+        x[i] += (u1 + (u2 + u3) * 2.f + u4) * h6;
+        y[i] += (v1 + (v2 + v3) * 2.f + v4) * h6;
+        vx[i] = u1 + (ax1 + (ax2 + ax3) * 2.f + ax4) * h6;
+        vy[i] = v1 + (ay1 + (ay2 + ay3) * 2.f + ay4) * h6;
+    }
+
+    void driftCollideWallsScalar(float* x, float* y, float* vx, float* vy, const float* r,
+        int begin, int end, float dt, const WallBox& box) {
+        for (int i = begin; i < end; ++i)
+            driftCollideWallsOne(x, y, vx, vy, r, i, dt, box);
+    }
+
+    void dragFallScalar(float* y, float* vy, const float* k, const char* asleep,
+        int begin, int end, float g, float dt) {
+        for (int i = begin; i < end; ++i)
+            if (!asleep[i]) dragFallOne(y, vy, k, i, g, dt);
+    }
+
+    void kickWithDragScalar(float* vx, float* vy, const char* asleep,
+        int begin, int end, float k, float g, float dt) {
+        for (int i = begin; i < end; ++i)
+            if (!asleep[i]) kickWithDragOne(vx, vy, i, k, g, dt);
+    }
+
+    template <class Drag>
+    void dragFlightRk4Scalar(float* x, float* y, float* vx, float* vy, const char* done,
+        int begin, int end, float k, float g, float dt) {
+        for (int i = begin; i < end; ++i)
+            if (!done[i]) dragFlightRk4One<Drag>(x, y, vx, vy, i, k, g, dt);
+    }
+
+#if defined(KERNELS_X86)
+    // ---- AVX2 ----
+
+    // Sleep flags of 8 bodies widened to a lane mask of the awake ones
+    AVX2_TARGET inline __m256 awakeMask8(const char* asleep) {
+        const __m256i flags = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(asleep)));
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(flags, _mm256_setzero_si256()));
+    }
+
+    AVX2_TARGET void driftCollideWallsAvx2(float* x, float* y, float* vx, float* vy, const float* r,
+        int begin, int end, float dt, const WallBox& box) {
+        const __m256 vdt = _mm256_set1_ps(dt);
+        const __m256 negE = _mm256_set1_ps(-box.restitution);
+        const __m256 left = _mm256_set1_ps(box.left), right = _mm256_set1_ps(box.right);
+        const __m256 top = _mm256_set1_ps(box.top), bottom = _mm256_set1_ps(box.bottom);
+        int i = begin;
+        for (; i + 8 <= end; i += 8) {
+            __m256 pvx = _mm256_loadu_ps(vx + i), pvy = _mm256_loadu_ps(vy + i);
+            __m256 px = _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(pvx, vdt));
+            __m256 py = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(pvy, vdt));
+            const __m256 rad = _mm256_loadu_ps(r + i);
+
+            // Each wall: mask the lanes past it, then blend in the clamped
+            // position and reflected velocity
+            __m256 m = _mm256_cmp_ps(_mm256_sub_ps(px, rad), left, _CMP_LT_OQ);
+            px = _mm256_blendv_ps(px, _mm256_add_ps(left, rad), m);
+            pvx = _mm256_blendv_ps(pvx, _mm256_mul_ps(pvx, negE), m);
+            m = _mm256_cmp_ps(_mm256_add_ps(px, rad), right, _CMP_GT_OQ);
+            px = _mm256_blendv_ps(px, _mm256_sub_ps(right, rad), m);
+            pvx = _mm256_blendv_ps(pvx, _mm256_mul_ps(pvx, negE), m);
+            m = _mm256_cmp_ps(_mm256_sub_ps(py, rad), top, _CMP_LT_OQ);
+            py = _mm256_blendv_ps(py, _mm256_add_ps(top, rad), m);
+            pvy = _mm256_blendv_ps(pvy, _mm256_mul_ps(pvy, negE), m);
+            m = _mm256_cmp_ps(_mm256_add_ps(py, rad), bottom, _CMP_GT_OQ);
+            py = _mm256_blendv_ps(py, _mm256_sub_ps(bottom, rad), m);
+            pvy = _mm256_blendv_ps(pvy, _mm256_mul_ps(pvy, negE), m);
+
+            _mm256_storeu_ps(x + i, px);
+            _mm256_storeu_ps(y + i, py);
+            _mm256_storeu_ps(vx + i, pvx);
+            _mm256_storeu_ps(vy + i, pvy);
+        }
+        for (; i < end; ++i)
+            driftCollideWallsOne(x, y, vx, vy, r, i, dt, box);
+    }
+
+    AVX2_TARGET void dragFallAvx2(float* y, float* vy, const float* k, const char* asleep,
+        int begin, int end, float g, float dt) {
+        const __m256 vdt = _mm256_set1_ps(dt), vg = _mm256_set1_ps(g);
+        int i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 awake = awakeMask8(asleep + i);
+            const __m256 v = _mm256_loadu_ps(vy + i);
+            const __m256 nv = _mm256_add_ps(v, _mm256_mul_ps(_mm256_sub_ps(vg, _mm256_mul_ps(_mm256_loadu_ps(k + i), v)), vdt));
+            const __m256 p = _mm256_loadu_ps(y + i);
+            const __m256 np = _mm256_add_ps(p, _mm256_mul_ps(nv, vdt));
+            _mm256_storeu_ps(vy + i, _mm256_blendv_ps(v, nv, awake));
+            _mm256_storeu_ps(y + i, _mm256_blendv_ps(p, np, awake));
+        }
+        for (; i < end; ++i)
+            if (!asleep[i]) dragFallOne(y, vy, k, i, g, dt);
+    }
+
+    AVX2_TARGET void kickWithDragAvx2(float* vx, float* vy, const char* asleep,
+        int begin, int end, float k, float g, float dt) {
+        const __m256 vdt = _mm256_set1_ps(dt), vg = _mm256_set1_ps(g), vk = _mm256_set1_ps(k);
+        int i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 awake = awakeMask8(asleep + i);
+            const __m256 u = _mm256_loadu_ps(vx + i), v = _mm256_loadu_ps(vy + i);
+            const __m256 nu = _mm256_sub_ps(u, _mm256_mul_ps(_mm256_mul_ps(vk, u), vdt));
+            const __m256 nv = _mm256_add_ps(v, _mm256_mul_ps(_mm256_sub_ps(vg, _mm256_mul_ps(vk, v)), vdt));
+            _mm256_storeu_ps(vx + i, _mm256_blendv_ps(u, nu, awake));
+            _mm256_storeu_ps(vy + i, _mm256_blendv_ps(v, nv, awake));
+        }
+        for (; i < end; ++i)
+            if (!asleep[i]) kickWithDragOne(vx, vy, i, k, g, dt);
+    }
+
+    template <class Drag>
+    AVX2_TARGET inline void dragAccel8(__m256 vx, __m256 vy, __m256 k, __m256 g, __m256& ax, __m256& ay) {
+        __m256 c = k;
+        if constexpr (Drag::QUADRATIC)
+            c = _mm256_mul_ps(k, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy))));
+        ax = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(c, vx));
+        ay = _mm256_sub_ps(g, _mm256_mul_ps(c, vy));
+    }
+
+    // (a + (b + c) * 2 + d) * h6, the weighted RK4 sum
+    AVX2_TARGET inline __m256 rk4Sum(__m256 a, __m256 b, __m256 c, __m256 d, __m256 two, __m256 h6) {
+        return _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(a, _mm256_mul_ps(_mm256_add_ps(b, c), two)), d), h6);
+    }
+
+    template <class Drag>
+    AVX2_TARGET void dragFlightRk4Avx2(float* x, float* y, float* vx, float* vy, const char* done,
+        int begin, int end, float k, float g, float dt) {
+        const __m256 vk = _mm256_set1_ps(k), vg = _mm256_set1_ps(g), two = _mm256_set1_ps(2.f);
+        const __m256 h = _mm256_set1_ps(dt), h2 = _mm256_set1_ps(dt * 0.5f), h6 = _mm256_set1_ps(dt / 6.f);
+        int i = begin;
+        for (; i + 8 <= end; i += 8) {
+            const __m256 active = awakeMask8(done + i);
+            const __m256 u1 = _mm256_loadu_ps(vx + i), v1 = _mm256_loadu_ps(vy + i);
+            __m256 ax1, ay1, ax2, ay2, ax3, ay3, ax4, ay4;
+            dragAccel8<Drag>(u1, v1, vk, vg, ax1, ay1);
+            const __m256 u2 = _mm256_add_ps(u1, _mm256_mul_ps(ax1, h2)), v2 = _mm256_add_ps(v1, _mm256_mul_ps(ay1, h2));
+            dragAccel8<Drag>(u2, v2, vk, vg, ax2, ay2);
+            const __m256 u3 = _mm256_add_ps(u1, _mm256_mul_ps(ax2, h2)), v3 = _mm256_add_ps(v1, _mm256_mul_ps(ay2, h2));
+            dragAccel8<Drag>(u3, v3, vk, vg, ax3, ay3);
+            const __m256 u4 = _mm256_add_ps(u1, _mm256_mul_ps(ax3, h)), v4 = _mm256_add_ps(v1, _mm256_mul_ps(ay3, h));
+            dragAccel8<Drag>(u4, v4, vk, vg, ax4, ay4);
+            const __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i);
+            _mm256_storeu_ps(x + i, _mm256_blendv_ps(px, _mm256_add_ps(px, rk4Sum(u1, u2, u3, u4, two, h6)), active));
+            _mm256_storeu_ps(y + i, _mm256_blendv_ps(py, _mm256_add_ps(py, rk4Sum(v1, v2, v3, v4, two, h6)), active));
+            _mm256_storeu_ps(vx + i, _mm256_blendv_ps(u1, _mm256_add_ps(u1, rk4Sum(ax1, ax2, ax3, ax4, two, h6)), active));
+            _mm256_storeu_ps(vy + i, _mm256_blendv_ps(v1, _mm256_add_ps(v1, rk4Sum(ay1, ay2, ay3, ay4, two, h6)), active));
+        }
+        for (; i < end; ++i)
+            if (!done[i]) dragFlightRk4One<Drag>(x, y, vx, vy, i, k, g, dt);
+    }
+
+    bool cpuHasAvx2() {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0, avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false; // OS saves YMM state
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+#if defined(KERNELS_NEON)
+    // ---- NEON ----
+
+    inline uint32x4_t awakeMask4(const char* asleep) {
+        const uint32x4_t mask = {
+            asleep[0] ? 0u : ~0u, asleep[1] ? 0u : ~0u,
+            asleep[2] ? 0u : ~0u, asleep[3] ? 0u : ~0u };
+        return mask;
+    }
+
+    void driftCollideWallsNeon(float* x, float* y, float* vx, float* vy, const float* r,
+        int begin, int end, float dt, const WallBox& box) {
+        const float32x4_t vdt = vdupq_n_f32(dt);
+        const float32x4_t negE = vdupq_n_f32(-box.restitution);
+        const float32x4_t left = vdupq_n_f32(box.left), right = vdupq_n_f32(box.right);
+        const float32x4_t top = vdupq_n_f32(box.top), bottom = vdupq_n_f32(box.bottom);
+        int i = begin;
+        for (; i + 4 <= end; i += 4) {
+            float32x4_t pvx = vld1q_f32(vx + i), pvy = vld1q_f32(vy + i);
+            float32x4_t px = vaddq_f32(vld1q_f32(x + i), vmulq_f32(pvx, vdt));
+            float32x4_t py = vaddq_f32(vld1q_f32(y + i), vmulq_f32(pvy, vdt));
+            const float32x4_t rad = vld1q_f32(r + i);
+
+            uint32x4_t m = vcltq_f32(vsubq_f32(px, rad), left);
+            px = vbslq_f32(m, vaddq_f32(left, rad), px);
+            pvx = vbslq_f32(m, vmulq_f32(pvx, negE), pvx);
+            m = vcgtq_f32(vaddq_f32(px, rad), right);
+            px = vbslq_f32(m, vsubq_f32(right, rad), px);
+            pvx = vbslq_f32(m, vmulq_f32(pvx, negE), pvx);
+            m = vcltq_f32(vsubq_f32(py, rad), top);
+            py = vbslq_f32(m, vaddq_f32(top, rad), py);
+            pvy = vbslq_f32(m, vmulq_f32(pvy, negE), pvy);
+            m = vcgtq_f32(vaddq_f32(py, rad), bottom);
+            py = vbslq_f32(m, vsubq_f32(bottom, rad), py);
+            pvy = vbslq_f32(m, vmulq_f32(pvy, negE), pvy);
+
+            vst1q_f32(x + i, px);
+            vst1q_f32(y + i, py);
+            vst1q_f32(vx + i, pvx);
+            vst1q_f32(vy + i, pvy);
+        }
+        for (; i < end; ++i)
+            driftCollideWallsOne(x, y, vx, vy, r, i, dt, box);
+    }
+
+    void dragFallNeon(float* y, float* vy, const float* k, const char* asleep,
+        int begin, int end, float g, float dt) {
+        const float32x4_t vdt = vdupq_n_f32(dt), vg = vdupq_n_f32(g);
+        int i = begin;
+        for (; i + 4 <= end; i += 4) {
+            const uint32x4_t awake = awakeMask4(asleep + i);
+            const float32x4_t v = vld1q_f32(vy + i);
+            const float32x4_t nv = vaddq_f32(v, vmulq_f32(vsubq_f32(vg, vmulq_f32(vld1q_f32(k + i), v)), vdt));
+            const float32x4_t p = vld1q_f32(y + i);
+            const float32x4_t np = vaddq_f32(p, vmulq_f32(nv, vdt));
+            vst1q_f32(vy + i, vbslq_f32(awake, nv, v));
+            vst1q_f32(y + i, vbslq_f32(awake, np, p));
+        }
+        for (; i < end; ++i)
+            if (!asleep[i]) dragFallOne(y, vy, k, i, g, dt);
+    }
+
+    void kickWithDragNeon(float* vx, float* vy, const char* asleep,
+        int begin, int end, float k, float g, float dt) {
+        const float32x4_t vdt = vdupq_n_f32(dt), vg = vdupq_n_f32(g), vk = vdupq_n_f32(k);
+        int i = begin;
+        for (; i + 4 <= end; i += 4) {
+            const uint32x4_t awake = awakeMask4(asleep + i);
+            const float32x4_t u = vld1q_f32(vx + i), v = vld1q_f32(vy + i);
+            const float32x4_t nu = vsubq_f32(u, vmulq_f32(vmulq_f32(vk, u), vdt));
+            const float32x4_t nv = vaddq_f32(v, vmulq_f32(vsubq_f32(vg, vmulq_f32(vk, v)), vdt));
+            vst1q_f32(vx + i, vbslq_f32(awake, nu, u));
+            vst1q_f32(vy + i, vbslq_f32(awake, nv, v));
+        }
+        for (; i < end; ++i)
+            if (!asleep[i]) kickWithDragOne(vx, vy, i, k, g, dt);
+    }
+
+    template <class Drag>
+    inline void dragAccel4(float32x4_t vx, float32x4_t vy, float32x4_t k, float32x4_t g,
+        float32x4_t& ax, float32x4_t& ay) {
+        float32x4_t c = k;
+        if constexpr (Drag::QUADRATIC)
+            c = vmulq_f32(k, vsqrtq_f32(vaddq_f32(vmulq_f32(vx, vx), vmulq_f32(vy, vy))));
+        ax = vsubq_f32(vdupq_n_f32(0.f), vmulq_f32(c, vx));
+        ay = vsubq_f32(g, vmulq_f32(c, vy));
+    }
+
+    inline float32x4_t rk4Sum(float32x4_t a, float32x4_t b, float32x4_t c, float32x4_t d,
+        float32x4_t two, float32x4_t h6) {
+        return vmulq_f32(vaddq_f32(vaddq_f32(a, vmulq_f32(vaddq_f32(b, c), two)), d), h6);
+    }
+
+    template <class Drag>
+    void dragFlightRk4Neon(float* x, float* y, float* vx, float* vy, const char* done,
+        int begin, int end, float k, float g, float dt) {
+        const float32x4_t vk = vdupq_n_f32(k), vg = vdupq_n_f32(g), two = vdupq_n_f32(2.f);
+        const float32x4_t h = vdupq_n_f32(dt), h2 = vdupq_n_f32(dt * 0.5f), h6 = vdupq_n_f32(dt / 6.f);
+        int i = begin;
+        for (; i + 4 <= end; i += 4) {
+            const uint32x4_t active = awakeMask4(done + i);
+            const float32x4_t u1 = vld1q_f32(vx + i), v1 = vld1q_f32(vy + i);
+            float32x4_t ax1, ay1, ax2, ay2, ax3, ay3, ax4, ay4;
+            dragAccel4<Drag>(u1, v1, vk, vg, ax1, ay1);
+            const float32x4_t u2 = vaddq_f32(u1, vmulq_f32(ax1, h2)), v2 = vaddq_f32(v1, vmulq_f32(ay1, h2));
+            dragAccel4<Drag>(u2, v2, vk, vg, ax2, ay2);
+            const float32x4_t u3 = vaddq_f32(u1, vmulq_f32(ax2, h2)), v3 = vaddq_f32(v1, vmulq_f32(ay2, h2));
+            dragAccel4<Drag>(u3, v3, vk, vg, ax3, ay3);
+            const float32x4_t u4 = vaddq_f32(u1, vmulq_f32(ax3, h)), v4 = vaddq_f32(v1, vmulq_f32(ay3, h));
+            dragAccel4<Drag>(u4, v4, vk, vg, ax4, ay4);
+            const float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i);
+            vst1q_f32(x + i, vbslq_f32(active, vaddq_f32(px, rk4Sum(u1, u2, u3, u4, two, h6)), px));
+            vst1q_f32(y + i, vbslq_f32(active, vaddq_f32(py, rk4Sum(v1, v2, v3, v4, two, h6)), py));
+            vst1q_f32(vx + i, vbslq_f32(active, vaddq_f32(u1, rk4Sum(ax1, ax2, ax3, ax4, two, h6)), u1));
+            vst1q_f32(vy + i, vbslq_f32(active, vaddq_f32(v1, rk4Sum(ay1, ay2, ay3, ay4, two, h6)), v1));
+        }
+        for (; i < end; ++i)
+            if (!done[i]) dragFlightRk4One<Drag>(x, y, vx, vy, i, k, g, dt);
+    }
+#endif
+
+    const SimdKernels SCALAR_KERNELS{ SimdLevel::Scalar, "scalar", driftCollideWallsScalar, dragFallScalar, kickWithDragScalar,
+        dragFlightRk4Scalar<LinearDrag>, dragFlightRk4Scalar<QuadraticDrag> };
+#if defined(KERNELS_X86)
+    const SimdKernels AVX2_KERNELS{ SimdLevel::Avx2, "AVX2", driftCollideWallsAvx2, dragFallAvx2, kickWithDragAvx2,
+        dragFlightRk4Avx2<LinearDrag>, dragFlightRk4Avx2<QuadraticDrag> };
+#endif
+#if defined(KERNELS_NEON)
+    const SimdKernels NEON_KERNELS{ SimdLevel::Neon, "NEON", driftCollideWallsNeon, dragFallNeon, kickWithDragNeon,
+        dragFlightRk4Neon<LinearDrag>, dragFlightRk4Neon<QuadraticDrag> };
+#endif
+
+    const SimdKernels* kernelsFor(SimdLevel level) {
+#if defined(KERNELS_X86)
+        if (level == SimdLevel::Avx2) return &AVX2_KERNELS;
+#endif
+#if defined(KERNELS_NEON)
+        if (level == SimdLevel::Neon) return &NEON_KERNELS;
+#endif
+        return &SCALAR_KERNELS;
+    }
+
+    const SimdKernels*& activeKernels() {
+        static const SimdKernels* active = kernelsFor(detectSimdLevel());
+        return active;
+    }
+}
+
+SimdLevel detectSimdLevel() {
+#if defined(KERNELS_X86)
+    static const bool avx2 = cpuHasAvx2();
+    return avx2 ? SimdLevel::Avx2 : SimdLevel::Scalar;
+#elif defined(KERNELS_NEON)
+    return SimdLevel::Neon; // baseline on every NEON target we build for
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+const SimdKernels& simdKernels() {
+    return *activeKernels();
+}
+
+void setSimdLevel(SimdLevel level) {
+    const SimdLevel best = detectSimdLevel();
+    activeKernels() = kernelsFor(static_cast<int>(level) > static_cast<int>(best) ? best : level);
+}
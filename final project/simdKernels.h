@@ -0,0 +1,51 @@
+#pragma once
+
+// Hot per-body loops over SoA arrays, in AVX2 (8 bodies per instruction),
+// NEON (4) and scalar versions. The best level the CPU supports is picked
+// at runtime on first use. Every version does the same IEEE operations in
+// the same order (no FMA contraction), so results match bit for bit.
+enum class SimdLevel { Scalar, Neon, Avx2 };
+
+// Axis-aligned container the wall kernel clamps and reflects against.
+struct WallBox {
+    float left, top, right, bottom;
+    float restitution;
+};
+
+struct SimdKernels {
+    SimdLevel level;
+    const char* name;
+    // x += vx * dt, y += vy * dt, then branchless clamp and reflect at each
+    // wall, in the order left, right, top, bottom.
+    void (*driftCollideWalls)(float* x, float* y, float* vx, float* vy, const float* r,
+        int begin, int end, float dt, const WallBox& box);
+    // Falling with linear drag for awake bodies: vy += (g - k * vy) * dt,
+    // then y += vy * dt. Bodies flagged in asleep are untouched.
+    void (*dragFall)(float* y, float* vy, const float* k, const char* asleep,
+        int begin, int end, float g, float dt);
+    // Velocity half of the above with one drag coefficient for every body:
+    // vx -= k * vx * dt, vy += (g - k * vy) * dt, skipping sleeping bodies.
+    void (*kickWithDrag)(float* vx, float* vy, const char* asleep,
+        int begin, int end, float k, float g, float dt);
+    // One RK4 step of flight under gravity g with drag: acceleration is
+    // (0, g) - k * v, or (0, g) - k * |v| * v when quadratic. Bodies flagged
+    // in done are untouched. One prebuilt loop per drag model, picked at
+    // compile time by dragFlightRk4<Drag>() (policies in sceneConfig.h).
+    using DragFlightRk4 = void (*)(float* x, float* y, float* vx, float* vy, const char* done,
+        int begin, int end, float k, float g, float dt);
+    DragFlightRk4 linearDragFlightRk4;
+    DragFlightRk4 quadraticDragFlightRk4;
+
+    template <class Drag>
+    DragFlightRk4 dragFlightRk4() const {
+        if constexpr (Drag::QUADRATIC) return quadraticDragFlightRk4;
+        else return linearDragFlightRk4;
+    }
+};
+
+// The dispatched kernel table.
+const SimdKernels& simdKernels();
+// Best level this CPU supports.
+SimdLevel detectSimdLevel();
+// Forces a level for comparisons (clamped to what the CPU supports).
+void setSimdLevel(SimdLevel level);
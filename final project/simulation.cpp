@@ -0,0 +1,179 @@
+#include "simulation.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "assets.h"
+#include "fixedStep.h"
+#include "frameArena.h"
+#include "heapCounter.h"
+#include "profiler.h"
+#include "jobSystem.h"
+
+namespace {
+    bool pipelineEnabled() {
+        const char* env = std::getenv("PHYSICS_PIPELINE");
+        return env == nullptr || std::string(env) != "0";
+    }
+
+    // Input the main thread polled, waiting for the simulation thread
+    class EventQueue {
+    public:
+        void push(const sf::Event& event) {
+            std::lock_guard<std::mutex> lock(mutex);
+            events.push_back(event);
+        }
+        // Swaps the pending events into out, which is cleared first
+        void drain(std::vector<sf::Event>& out) {
+            out.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            out.swap(events);
+        }
+
+    private:
+        std::mutex mutex;
+        std::vector<sf::Event> events;
+    };
+
+    // Closes the window on Escape or the close button; true if the event
+    // was the engine's to handle.
+    bool handleEngineEvent(const sf::Event& event, sf::RenderWindow& window, ProfilerOverlay& overlay) {
+        overlay.handleEvent(event);
+        if (event.type == sf::Event::Closed ||
+            (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)) {
+            window.close();
+            return true;
+        }
+        return false;
+    }
+
+    // Heap allocations so far by this thread and by jobs on the workers
+    std::uint64_t steppingAllocations(const JobSystem& pool) {
+        std::uint64_t n = threadHeapAllocations();
+        for (int t = 1; t < pool.size(); ++t)
+            n += pool.threadStats(t).heapAllocations;
+        return n;
+    }
+
+    // Runs the steps the time since the last call asks for.
+    FrameInfo advance(Simulation& simulation, const JobSystem& pool, FixedStep& stepper, sf::Clock& clock) {
+        FrameInfo frame;
+        frame.seconds = clock.restart().asSeconds();
+        frame.steps = stepper.advance(frame.seconds);
+        frame.dt = stepper.dt();
+        sf::Clock physicsClock;
+        const std::uint64_t allocationsBefore = steppingAllocations(pool);
+        for (int s = 0; s < frame.steps; ++s) {
+            // Step scratch on this thread's arena goes back after every step
+            const ArenaScope scratch;
+            simulation.step(frame.dt);
+        }
+        profiler().addSteps(frame.steps, steppingAllocations(pool) - allocationsBefore);
+        frame.physicsMs = physicsClock.getElapsedTime().asMicroseconds() / 1000.f;
+        frame.alpha = stepper.alpha();
+        return frame;
+    }
+
+    void runSerial(Simulation& simulation, const JobSystem& pool, sf::RenderWindow& window, ProfilerOverlay& profilerOverlay) {
+        FixedStep stepper(simulation.stepHz());
+        sf::Clock clock;
+        while (window.isOpen()) {
+            profiler().beginFrame();
+            assets().poll();
+            ProfileZone phase("Events");
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (handleEngineEvent(event, window, profilerOverlay)) break;
+                simulation.handleEvent(event, window);
+            }
+            if (!window.isOpen()) break;
+
+            phase.next("Physics");
+            const FrameInfo frame = advance(simulation, pool, stepper, clock);
+
+            phase.next("Update");
+            simulation.update(window, frame);
+
+            phase.next("Render");
+            profilerOverlay.update();
+            window.clear(simulation.clearColor());
+            simulation.render(window, frame);
+            window.setView(window.getDefaultView());
+            window.draw(profilerOverlay);
+
+            phase.next("Display");
+            window.display();
+        }
+    }
+
+    // The simulation thread steps as time comes due and publishes through
+    // update(); this thread only polls input and draws the newest snapshot,
+    // so physics runs while it renders and waits in display().
+    void runPipelined(Simulation& simulation, const JobSystem& pool, sf::RenderWindow& window, ProfilerOverlay& profilerOverlay) {
+        EventQueue events;
+        std::atomic<bool> running{ true };
+        std::thread simulationThread([&]() {
+            FixedStep stepper(simulation.stepHz());
+            sf::Clock clock;
+            std::vector<sf::Event> batch;
+            while (running.load(std::memory_order_acquire)) {
+                events.drain(batch);
+                for (const sf::Event& event : batch)
+                    simulation.handleEvent(event, window);
+                const FrameInfo frame = advance(simulation, pool, stepper, clock);
+                simulation.update(window, frame);
+                // Sleep until the next step is due
+                std::this_thread::sleep_for(std::chrono::duration<float>((1.f - frame.alpha) * frame.dt));
+            }
+        });
+
+        sf::Clock clock;
+        while (window.isOpen()) {
+            profiler().beginFrame();
+            assets().poll();
+            ProfileZone phase("Events");
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (handleEngineEvent(event, window, profilerOverlay)) break;
+                events.push(event);
+            }
+            if (!window.isOpen()) break;
+
+            phase.next("Render");
+            FrameInfo frame;
+            frame.seconds = clock.restart().asSeconds();
+            profilerOverlay.update();
+            window.clear(simulation.clearColor());
+            simulation.render(window, frame);
+            window.setView(window.getDefaultView());
+            window.draw(profilerOverlay);
+
+            phase.next("Display");
+            window.display();
+        }
+        running.store(false, std::memory_order_release);
+        simulationThread.join();
+    }
+}
+
+void runSimulation(Simulation& simulation) {
+    const WindowSettings settings = simulation.windowSettings();
+    sf::RenderWindow window(settings.mode, settings.title, settings.style);
+    window.setFramerateLimit(60);
+
+    // All cores, shared by whatever the scene runs in parallel
+    JobSystem pool;
+    ProfilerOverlay profilerOverlay(assets().font("OpenSans-Regular.ttf"), &pool);
+    simulation.start(window, pool);
+
+    // The profiler belongs to this thread, so the simulation thread's zones
+    // are skipped rather than mixed into the render timeline
+    profiler();
+    if (simulation.pipelined() && pipelineEnabled())
+        runPipelined(simulation, pool, window, profilerOverlay);
+    else
+        runSerial(simulation, pool, window, profilerOverlay);
+}
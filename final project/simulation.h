@@ -0,0 +1,56 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+
+class JobSystem;
+
+// What the engine measured for the frame being updated and drawn.
+struct FrameInfo {
+    float seconds = 0.f;   // wall time since the previous frame
+    int steps = 0;         // fixed steps run this frame
+    float dt = 0.f;        // length of one step
+    float alpha = 0.f;     // render interpolation between the last two steps
+    float physicsMs = 0.f; // wall time of this frame's steps
+};
+
+struct WindowSettings {
+    sf::VideoMode mode;
+    std::string title;
+    sf::Uint32 style = sf::Style::Default;
+};
+
+// An interactive scene driven by runSimulation(). The engine owns the window,
+// the fixed-step clock, the job system, the profiler and the asset pump; a
+// scene only reacts to input, advances its physics one fixed step at a time
+// and draws. Each frame runs handleEvent() for every pending event, step()
+// as often as the accumulated time asks for, update() once, then render().
+//
+// A pipelined scene runs handleEvent(), step() and update() on a simulation
+// thread of their own, which keeps stepping while the main thread draws and
+// waits for vsync. update() must then hand render() everything it draws
+// through a TripleBuffer (tripleBuffer.h), and neither side may touch state
+// the other writes. Off the main thread the window is only good for
+// coordinate mapping with a view the scene owns.
+class Simulation {
+public:
+    virtual ~Simulation() = default;
+
+    virtual WindowSettings windowSettings() const = 0;
+    virtual float stepHz() const { return 240.f; }
+    virtual sf::Color clearColor() const { return sf::Color::Black; }
+    virtual bool pipelined() const { return false; }
+
+    // Called once the window is open, before the first frame.
+    virtual void start(sf::RenderWindow& window, JobSystem& pool) = 0;
+    virtual void handleEvent(const sf::Event& event, sf::RenderWindow& window) = 0;
+    virtual void step(float dt) = 0;
+    // Per-frame work after stepping: wall-clock timers, readouts, trails.
+    virtual void update(sf::RenderWindow& window, const FrameInfo& frame) { (void)window; (void)frame; }
+    // Draws into a cleared window; the engine draws the profiler on top.
+    virtual void render(sf::RenderWindow& window, const FrameInfo& frame) = 0;
+};
+
+// Opens the scene's window and runs it until the window closes. Escape and
+// the close button end every scene; F3/F4 drive the profiler overlay.
+// PHYSICS_PIPELINE=0 in the environment runs pipelined scenes serially too.
+void runSimulation(Simulation& simulation);
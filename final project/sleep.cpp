@@ -0,0 +1,104 @@
+#include "sleep.h"
+#include <algorithm>
+#include "frameArena.h"
+
+namespace {
+    int findRoot(FrameVector<int>& parent, int i) {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]]; // path halving
+            i = parent[i];
+        }
+        return i;
+    }
+}
+
+void SleepSystem::resize(std::size_t bodies) {
+    if (bodies <= sleeping.size()) return;
+    const std::size_t first = sleeping.size();
+    sleeping.resize(bodies, 0);
+    restTime.resize(bodies, 0.f);
+    nextInIsland.resize(bodies);
+    for (std::size_t i = first; i < bodies; ++i)
+        nextInIsland[i] = static_cast<int>(i);
+}
+
+void SleepSystem::wake(int i) {
+    if (!sleeping[i]) return;
+    int j = i;
+    do {
+        sleeping[j] = 0;
+        restTime[j] = 0.f;
+        --sleepers;
+        const int next = nextInIsland[j];
+        nextInIsland[j] = j;
+        j = next;
+    } while (j != i);
+}
+
+void SleepSystem::wakeAll() {
+    for (std::size_t i = 0; i < sleeping.size(); ++i) {
+        sleeping[i] = 0;
+        restTime[i] = 0.f;
+        nextInIsland[i] = static_cast<int>(i);
+    }
+    sleepers = 0;
+}
+
+void SleepSystem::sleepNow(int i, ParticleStore& p) {
+    if (sleeping[i]) return;
+    sleeping[i] = 1;
+    nextInIsland[i] = i;
+    p.vx[i] = p.vy[i] = 0.f;
+    ++sleepers;
+}
+
+void SleepSystem::update(ParticleStore& p, const std::vector<BodyPair>& contacts, float dt) {
+    const int count = static_cast<int>(p.size());
+    const float limit2 = sleepSpeed * sleepSpeed;
+    bool anyReady = false;
+    for (int i = 0; i < count; ++i) {
+        if (sleeping[i]) continue;
+        const float v2 = p.vx[i] * p.vx[i] + p.vy[i] * p.vy[i];
+        restTime[i] = v2 < limit2 ? restTime[i] + dt : 0.f;
+        anyReady = anyReady || restTime[i] >= timeToSleep;
+    }
+    if (!anyReady) return;
+
+    // Islands of awake bodies joined by contacts; a sleeping neighbour is
+    // static, so it does not join islands together. The union-find scratch
+    // lives on the step arena.
+    const ArenaScope scratch;
+    FrameVector<int> parent(count);
+    for (int i = 0; i < count; ++i) parent[i] = i;
+    for (const BodyPair& c : contacts) {
+        if (sleeping[c.a] || sleeping[c.b]) continue;
+        const int ra = findRoot(parent, c.a), rb = findRoot(parent, c.b);
+        if (ra != rb) parent[std::max(ra, rb)] = std::min(ra, rb);
+    }
+    FrameVector<float> islandRest(count, timeToSleep);
+    for (int i = 0; i < count; ++i) {
+        if (!sleeping[i]) {
+            const int root = findRoot(parent, i);
+            islandRest[root] = std::min(islandRest[root], restTime[i]);
+        }
+    }
+
+    // Link each resting island into a circular list and put it to sleep
+    FrameVector<int> islandTail(count, -1);
+    for (int i = 0; i < count; ++i) {
+        if (sleeping[i]) continue;
+        const int root = findRoot(parent, i);
+        if (islandRest[root] < timeToSleep) continue;
+        sleeping[i] = 1;
+        ++sleepers;
+        p.vx[i] = p.vy[i] = 0.f;
+        if (islandTail[root] < 0) {
+            nextInIsland[i] = i;
+        }
+        else {
+            nextInIsland[i] = nextInIsland[islandTail[root]];
+            nextInIsland[islandTail[root]] = i;
+        }
+        islandTail[root] = i;
+    }
+}
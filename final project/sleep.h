@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "particleStore.h"
+#include "spatialGrid.h"
+#include "memoryUsage.h"
+
+// Velocity-threshold sleeping shared by the simulations. Bodies slower than
+// sleepSpeed accumulate rest time; an island of touching bodies goes to sleep
+// once all of its members have rested for timeToSleep, and wakes as a whole.
+// Sleeping bodies have zero velocity and act as static for contacts.
+class SleepSystem {
+public:
+    float sleepSpeed = 4.f;   // px/s
+    float timeToSleep = 0.5f; // s
+
+    // Grows to the store's size; new bodies start awake.
+    void resize(std::size_t bodies);
+
+    bool asleep(int i) const { return sleeping[i] != 0; }
+    const char* sleepFlags() const { return sleeping.data(); }
+    std::size_t sleepingCount() const { return sleepers; }
+
+    // Wakes i and every body that fell asleep in the same island.
+    void wake(int i);
+    void wakeAll();
+    // Puts i to sleep on its own right away (e.g. a ball that hit the floor).
+    void sleepNow(int i, ParticleStore& p);
+
+    // After the solver: updates rest timers and puts islands whose members
+    // (connected through `contacts`) have all rested long enough to sleep.
+    void update(ParticleStore& p, const std::vector<BodyPair>& contacts, float dt);
+
+    std::size_t memoryBytes() const {
+        return capacityBytes(sleeping, restTime, nextInIsland);
+    }
+
+private:
+    std::vector<char> sleeping;
+    std::vector<float> restTime;
+    std::vector<int> nextInIsland; // circular list through each sleeping island
+    std::size_t sleepers = 0;
+};
@@ -1,172 +1,186 @@
 
 #include <SFML/Graphics.hpp>
+#include <algorithm>
 #include <cmath>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <random>
-#include <map>
-#include <iostream>
 #include <cctype>
-
-constexpr float PI = 3.14159265358979323846f;
-constexpr float TIME_SCALE = 9999999.f;   // Speed time up for visible orbits
+#include <memory>
+#include "solarSystem.h"
+#include "circleBatch.h"
+#include "fixedStep.h"
+#include "nbody.h"
+#include "gpuForces.h"
+#include "trailRing.h"
+#include "replay.h"
+#include "sceneConfig.h"
+#include "starField.h"
+#include "assets.h"
+#include "simulation.h"
+#include "tripleBuffer.h"
+
+constexpr double ORBIT_TIME_SCALE = 9999999.0; // Speed time up for visible orbits
 constexpr float AU = 150.f;
-
-
-struct Star {
-    sf::CircleShape shape;
-    float twinkleSpeed;
-    float twinklePhase;
-};
-
-std::vector<Star> generateStars(int count, int width, int height) {
+constexpr int NBODY_ASTEROIDS = 5000;
+constexpr std::size_t KINEMATIC_TRAIL_POINTS = 80;
+constexpr std::size_t NBODY_TRAIL_POINTS = 12000; // ~200 s at 60 fps
+// Background density, and how many window widths the field spans: the
+// widest zoom (0.1) shows ten
+constexpr int STARS_PER_SCREEN = 400;
+constexpr float STAR_FIELD_SCREENS = 11.f;
+// Level of detail by radius on screen: a pixel below POINT_PIXELS, a flat
+// disc up to SPRITE_PIXELS, the texture above. Zoomed out past
+// COARSE_TRAIL_ZOOM, trails draw every TRAIL_DECIMATION-th point.
+constexpr float POINT_PIXELS = 1.f;
+constexpr float SPRITE_PIXELS = 6.f;
+constexpr float COARSE_TRAIL_ZOOM = 0.5f;
+constexpr float SUN_RADIUS = 60.f;
+const sf::Color ASTEROID_COLOR(170, 160, 150);
+constexpr std::size_t TRAIL_DECIMATION = 4;
+
+
+std::vector<Star> generateStars(int count, sf::FloatRect area, unsigned seed) {
     std::vector<Star> stars;
-    std::mt19937 rng(std::random_device{}());
-    std::uniform_int_distribution<int> distX(0, width);
-    std::uniform_int_distribution<int> distY(0, height);
+    stars.reserve(count);
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> distX(area.left, area.left + area.width);
+    std::uniform_real_distribution<float> distY(area.top, area.top + area.height);
     std::uniform_int_distribution<int> distSize(1, 3);
     std::uniform_real_distribution<float> distSpeed(0.5f, 2.f);
     std::uniform_real_distribution<float> distPhase(0.f, 6.28f);
 
     for (int i = 0; i < count; ++i) {
-        float size = distSize(rng);
-        sf::CircleShape star(size);
-        star.setOrigin(size, size);
-        star.setPosition(distX(rng), distY(rng));
-        star.setFillColor(sf::Color::White);
-
-        stars.push_back({ star, distSpeed(rng), distPhase(rng) });
+        float size = static_cast<float>(distSize(rng));
+        sf::Vector2f pos(distX(rng), distY(rng));
+        stars.push_back({ pos, size, distSpeed(rng), distPhase(rng) });
     }
     return stars;
 }
 
-struct Planet {
-    std::string name;
-    float orbitRadius;        // in pixels (scaled)
-    float orbitPeriod;        // days
-    float radius;             // pixels (used for scaling texture)
-    sf::Color baseColor;      // fallback color, not used here since we use textures
-    float currentOrbitAngle;  // radians
-
-    std::vector<sf::Vector2f> trail; // past positions for orbit trail
-
-    Planet(const std::string& n, float orbitR, float orbitP, float r, sf::Color c)
-        : name(n), orbitRadius(orbitR), orbitPeriod(orbitP), radius(r), baseColor(c), currentOrbitAngle(0)
-    {
-    }
-
-    void update(float elapsedSeconds) {
-        float orbitAngularSpeed = 2 * PI / (orbitPeriod * 86400.f / TIME_SCALE);       // rad/s
-        currentOrbitAngle += orbitAngularSpeed * elapsedSeconds;
+void Planet::update(double elapsedSeconds) {
+    previousOrbitAngle = currentOrbitAngle;
+    double orbitAngularSpeed = TWO_PI_DOUBLE / (orbitPeriod * 86400.0 / ORBIT_TIME_SCALE);       // rad/s
+    currentOrbitAngle += orbitAngularSpeed * elapsedSeconds;
 
-        if (currentOrbitAngle > 2 * PI) currentOrbitAngle -= 2 * PI;
-
-        if (trail.size() > 80) trail.erase(trail.begin());
-    }
-
-    sf::Vector2f getPosition(float cx, float cy) const {
-        return sf::Vector2f(
-            cx + orbitRadius * std::cos(currentOrbitAngle),
-            cy + orbitRadius * std::sin(currentOrbitAngle)
-        );
-    }
-
-    void addTrailPoint(sf::Vector2f pos) {
-        trail.push_back(pos);
-    }
-};
+    if (currentOrbitAngle > TWO_PI_DOUBLE) currentOrbitAngle -= TWO_PI_DOUBLE;
+}
 
+sf::Vector2f Planet::getPosition(float cx, float cy, float alpha) const {
+    double to = currentOrbitAngle;
+    if (to < previousOrbitAngle) to += TWO_PI_DOUBLE; // wrapped during the last step
+    double angle = previousOrbitAngle + (to - previousOrbitAngle) * alpha;
+    return sf::Vector2f(
+        cx + orbitRadius * static_cast<float>(std::cos(angle)),
+        cy + orbitRadius * static_cast<float>(std::sin(angle))
+    );
+}
 
-void runOrbitSimulation() {
-    sf::RenderWindow window(sf::VideoMode(1280, 900), "Solar System with Revolution Only", sf::Style::Close);
-    window.setFramerateLimit(60);
-
-    sf::Vector2f center(window.getSize().x / 2.f, window.getSize().y / 2.f);
-
-    auto stars = generateStars(400, window.getSize().x, window.getSize().y);
-
-    std::vector<Planet> planets = {
-        {"Mercury", 0.39f * AU, 88.f, 8.f, sf::Color(169, 169, 169)},
-        {"Venus", 0.72f * AU, 224.7f, 14.f, sf::Color(218, 165, 32)},
-        {"Earth", 1.f * AU, 365.25f, 16.f, sf::Color(70, 130, 180)},
-        {"Mars", 1.52f * AU, 687.f, 12.f, sf::Color(178, 34, 34)},
-        {"Jupiter", 5.2f * AU, 4331.f, 30.f, sf::Color(205, 133, 63)},
-        {"Saturn", 9.58f * AU, 10747.f, 26.f, sf::Color(210, 180, 140)},
-        {"Uranus", 19.22f * AU, 30589.f, 22.f, sf::Color(72, 209, 204)},
-        {"Neptune", 30.05f * AU, 59800.f, 22.f, sf::Color(25, 25, 112)}
+std::vector<Planet> makePlanets() {
+    return {
+        {"Mercury", 0.39f * AU, 88.f, 8.f, sf::Color(169, 169, 169), 1.66e-7f},
+        {"Venus", 0.72f * AU, 224.7f, 14.f, sf::Color(218, 165, 32), 2.45e-6f},
+        {"Earth", 1.f * AU, 365.25f, 16.f, sf::Color(70, 130, 180), 3.00e-6f},
+        {"Mars", 1.52f * AU, 687.f, 12.f, sf::Color(178, 34, 34), 3.23e-7f},
+        {"Jupiter", 5.2f * AU, 4331.f, 30.f, sf::Color(205, 133, 63), 9.55e-4f},
+        {"Saturn", 9.58f * AU, 10747.f, 26.f, sf::Color(210, 180, 140), 2.86e-4f},
+        {"Uranus", 19.22f * AU, 30589.f, 22.f, sf::Color(72, 209, 204), 4.37e-5f},
+        {"Neptune", 30.05f * AU, 59800.f, 22.f, sf::Color(25, 25, 112), 5.15e-5f}
     };
+}
 
-    sf::Font font;
-    if (!font.loadFromFile("OpenSans-Regular.ttf")) {
-        std::cerr << "Failed to load font OpenSans-Regular.ttf\n";
-    }
+float sunGravitationalParameter() {
+    // Kepler's third law: GM = 4 pi^2 a^3 / T^2 with T = Earth's scaled period
+    const double earthPeriod = 365.25 * 86400.0 / ORBIT_TIME_SCALE;
+    const double au = AU;
+    return static_cast<float>(TWO_PI_DOUBLE * TWO_PI_DOUBLE * au * au * au / (earthPeriod * earthPeriod));
+}
 
-    std::map<std::string, sf::Texture> textures;
-    std::vector<std::string> textureFiles = {
-        "sun.jpg", "mercury.jpg", "venus.jpg", "earth.jpg", "mars.jpg",
-        "jupiter.jpg", "saturn.jpg", "uranus.jpg", "neptune.jpg"
-    };
 
-    for (const auto& file : textureFiles) {
-        sf::Texture tex;
-        if (!tex.loadFromFile(file)) {
-            std::cerr << "Failed to load texture: " << file << std::endl;
-        }
-        else {
-            textures[file] = std::move(tex);
-        }
+namespace {
+    // World rect the orbit view shows
+    sf::FloatRect viewRect(sf::Vector2f viewCenter, sf::Vector2f screen, float zoom) {
+        const sf::Vector2f size = screen / zoom;
+        return sf::FloatRect(viewCenter - size / 2.f, size);
     }
 
-    // Setup sun sprite
-    sf::Sprite sunSprite;
-    if (textures.count("sun.jpg")) {
-        sunSprite.setTexture(textures["sun.jpg"]);
-        sf::Vector2u size = textures["sun.jpg"].getSize();
-        sunSprite.setOrigin(size.x / 2.f, size.y / 2.f);
-        sunSprite.setPosition(center);
-        float scale = (60.f * 2.f) / size.x;  // sun radius 60, so diameter *2
-        sunSprite.setScale(scale, scale);
+    bool circleVisible(const sf::FloatRect& view, float x, float y, float r) {
+        return x + r >= view.left && x - r <= view.left + view.width
+            && y + r >= view.top && y - r <= view.top + view.height;
     }
 
-    // Setup planet sprites
-    std::vector<sf::Sprite> planetSprites;
-    for (const auto& p : planets) {
-        std::string filename = p.name;
-        for (auto& c : filename) c = static_cast<char>(std::tolower(c));
-        filename += ".jpg";
-
-        sf::Sprite sprite;
-        if (textures.count(filename)) {
-            sprite.setTexture(textures[filename]);
-            sf::Vector2u size = textures[filename].getSize();
-            sprite.setOrigin(size.x / 2.f, size.y / 2.f);
-            float scale = (p.radius * 2.f) / size.x;
-            sprite.setScale(scale, scale);
+    class OrbitScene : public Simulation {
+    public:
+        WindowSettings windowSettings() const override {
+            return { sf::VideoMode(1280, 900), "Solar System with Revolution Only", sf::Style::Close };
         }
-        planetSprites.push_back(sprite);
-    }
-
-    sf::Text infoText;
-    infoText.setFont(font);
-    infoText.setCharacterSize(16);
-    infoText.setFillColor(sf::Color::White);
-    infoText.setPosition(10.f, 10.f);
-
-    sf::Clock clock;
+        sf::Color clearColor() const override { return sf::Color(5, 5, 15); }
+        // Orbits and the asteroid belt step on their own thread
+        bool pipelined() const override { return true; }
+
+        void start(sf::RenderWindow& window, JobSystem& threads) override {
+            pool = &threads;
+            screen = sf::Vector2f(window.getSize());
+            center = screen / 2.f;
+            viewCenter = center;
+
+            // Stars never move: bake them once, over everything the widest
+            // zoom can show around the sun
+            const sf::Vector2f span = screen * STAR_FIELD_SCREENS;
+            starField.build(generateStars(STARS_PER_SCREEN * int(STAR_FIELD_SCREENS * STAR_FIELD_SCREENS),
+                sf::FloatRect(center - span / 2.f, span), sessionSeed()));
+
+            // Textures decode in the background; bodies draw as coloured discs
+            // until theirs is uploaded
+            textureFiles = { "sun.jpg" };
+            for (const auto& p : planetTable) {
+                std::string filename = p.name;
+                for (auto& c : filename) c = static_cast<char>(std::tolower(c));
+                textureFiles.push_back(filename + ".jpg");
+            }
+            assets().prefetch(textureFiles);
+            planetSprites.resize(planetTable.size());
 
-    float zoom = 1.f;
-    sf::Vector2f viewCenter = center;
-    bool dragging = false;
-    sf::Vector2i lastMousePos;
+            sunFallback.setRadius(SUN_RADIUS);
+            sunFallback.setOrigin(SUN_RADIUS, SUN_RADIUS);
+            sunFallback.setFillColor(sf::Color(255, 255, 100));
 
-    while (window.isOpen()) {
-        sf::Event ev;
-        while (window.pollEvent(ev)) {
-            if (ev.type == sf::Event::Closed) window.close();
+            infoText.setFont(assets().font("OpenSans-Regular.ttf"));
+            infoText.setCharacterSize(16);
+            infoText.setFillColor(sf::Color::White);
+            infoText.setPosition(10.f, 10.f);
+        }
 
+        void handleEvent(const sf::Event& ev, sf::RenderWindow&) override {
             if (ev.type == sf::Event::KeyPressed) {
-                if (ev.key.code == sf::Keyboard::Escape) window.close();
+                if (ev.key.code == sf::Keyboard::G) {
+                    nbodyMode = !nbodyMode;
+                    if (nbodyMode) {
+                        nbody = makeSolarNBody(NBODY_ASTEROIDS, sessionSeed());
+                        asteroidRadius = 0.f;
+                        for (std::size_t b = planets.size() + 1; b < nbody.bodies.size(); ++b)
+                            asteroidRadius = std::max(asteroidRadius, nbody.bodies.radius[b]);
+                        nbody.pool = pool;
+                        nbody.integrator = integrator;
+                        if (useGpu) nbody.gpu = gpuForces.get();
+                    }
+                    ++modeChanges;
+                }
+                if (ev.key.code == sf::Keyboard::C && nbodyMode) {
+                    // The context is made on first use, on the thread that steps
+                    if (!gpuForces) gpuForces = std::make_unique<GpuNBodyForces>();
+                    useGpu = !useGpu && gpuForces->ready();
+                    nbody.gpu = useGpu ? gpuForces.get() : nullptr;
+                }
+                if (ev.key.code == sf::Keyboard::LBracket)
+                    nbody.theta = std::max(0.f, nbody.theta - 0.1f);
+                if (ev.key.code == sf::Keyboard::RBracket)
+                    nbody.theta = std::min(1.5f, nbody.theta + 0.1f);
+                if (ev.key.code == sf::Keyboard::I) {
+                    integrator = static_cast<IntegratorKind>(((int)integrator + 1) % 4);
+                    nbody.integrator = integrator;
+                }
             }
 
             if (ev.type == sf::Event::MouseWheelScrolled) {
@@ -178,89 +192,287 @@ void runOrbitSimulation() {
                 if (zoom > 10.f) zoom = 10.f;
             }
 
+            // The window cannot be resized, so a pixel is 1 / zoom world units
             if (ev.type == sf::Event::MouseButtonPressed && ev.mouseButton.button == sf::Mouse::Middle) {
                 dragging = true;
-                lastMousePos = sf::Mouse::getPosition(window);
+                lastMousePos = { ev.mouseButton.x, ev.mouseButton.y };
             }
             if (ev.type == sf::Event::MouseButtonReleased && ev.mouseButton.button == sf::Mouse::Middle) {
                 dragging = false;
             }
             if (ev.type == sf::Event::MouseMoved && dragging) {
-                sf::Vector2i newPos = sf::Mouse::getPosition(window);
-                sf::Vector2f delta = window.mapPixelToCoords(lastMousePos) - window.mapPixelToCoords(newPos);
-                viewCenter += delta;
+                const sf::Vector2i newPos{ ev.mouseMove.x, ev.mouseMove.y };
+                viewCenter += sf::Vector2f(lastMousePos - newPos) / zoom;
                 lastMousePos = newPos;
             }
-
         }
 
-        float dt = clock.restart().asSeconds();
-
-        // Update planets
-        for (auto& p : planets) {
-            p.update(dt);
-            p.addTrailPoint(p.getPosition(center.x, center.y)); // center of sun
+        void step(float dt) override {
+            if (nbodyMode) {
+                nbody.bodies.savePrevious();
+                nbody.step(dt);
+            }
+            else {
+                for (auto& p : planets)
+                    p.update(dt);
+            }
         }
 
+        void update(sf::RenderWindow&, const FrameInfo& frame) override {
+            const float alpha = frame.alpha;
+            OrbitSnapshot& snap = snapshots.back();
+            snap.sequence = ++published;
+            snap.modeChanges = modeChanges;
+            snap.nbodyMode = nbodyMode;
+            snap.viewCenter = viewCenter;
+            snap.zoom = zoom;
+            snap.view = viewRect(viewCenter, screen, zoom);
+            snap.planets.resize(planets.size());
+            snap.trail.resize(planets.size());
+            snap.asteroidX.clear();
+            snap.asteroidY.clear();
+            snap.asteroidR.clear();
+            if (nbodyMode) {
+                if (frame.steps > 0) forceMs = frame.physicsMs / frame.steps;
+                snap.sun = center + sf::Vector2f(nbody.bodies.renderX(0, alpha), nbody.bodies.renderY(0, alpha));
+                for (size_t i = 0; i < planets.size(); ++i) {
+                    const int b = static_cast<int>(i) + 1; // body 0 is the sun
+                    snap.planets[i] = snap.trail[i] = center + sf::Vector2f(
+                        nbody.bodies.renderX(b, alpha), nbody.bodies.renderY(b, alpha));
+                }
+                // Only asteroids in view are handed over, found through the
+                // Barnes-Hut tree the step just built over every body. Its
+                // positions are from the last force evaluation, at most a
+                // step from the drawn ones, so the rect grows by two steps of
+                // the fastest body and the largest radius. Under GPU forces
+                // there is no tree, and every asteroid gets the rect test.
+                const auto handOver = [&](std::size_t b) {
+                    const float x = center.x + nbody.bodies.renderX(b, alpha);
+                    const float y = center.y + nbody.bodies.renderY(b, alpha);
+                    const float r = nbody.bodies.radius[b];
+                    if (!circleVisible(snap.view, x, y, r)) return;
+                    snap.asteroidX.push_back(x);
+                    snap.asteroidY.push_back(y);
+                    snap.asteroidR.push_back(r);
+                };
+                const std::size_t firstAsteroid = planets.size() + 1;
+                if (const BarnesHutTree* tree = nbody.forceTree()) {
+                    const float margin = 2.f * nbody.maxSpeed() * frame.dt + asteroidRadius;
+                    const sf::FloatRect& v = snap.view;
+                    inView.clear();
+                    tree->query(v.left - center.x - margin, v.top - center.y - margin,
+                        v.left + v.width - center.x + margin, v.top + v.height - center.y + margin, inView);
+                    for (const int b : inView)
+                        if ((std::size_t)b >= firstAsteroid) handOver(b);
+                }
+                else {
+                    for (std::size_t b = firstAsteroid; b < nbody.bodies.size(); ++b)
+                        handOver(b);
+                }
+            }
+            else {
+                snap.sun = center;
+                for (size_t i = 0; i < planets.size(); ++i) {
+                    snap.planets[i] = planets[i].getPosition(viewCenter.x, viewCenter.y, alpha);
+                    snap.trail[i] = planets[i].getPosition(center.x, center.y, alpha); // center of sun
+                }
+            }
 
+            std::ostringstream info;
+            info << "Middle mouse drag: Pan view\n"
+                << "Mouse wheel: Zoom\n"
+                << "G: " << (nbodyMode ? "Kinematic orbits" : "N-body gravity") << "\n";
+            if (nbodyMode) {
+                info << "[ / ]: Opening angle " << nbody.theta << "\n"
+                    << "I: Integrator " << integratorName(integrator) << "\n"
+                    << "C: Forces ";
+                if (gpuForces && !gpuForces->ready())
+                    info << "on CPU (GPU unavailable: " << gpuForces->error() << ")\n";
+                else
+                    info << (useGpu ? "exact on GPU" : "Barnes-Hut on CPU") << "\n";
+                info << "Bodies: " << nbody.bodies.size();
+                if (!useGpu) info << "  tree nodes: " << nbody.treeNodes();
+                info << "  step: " << forceMs << " ms\n";
+            }
+            snap.info = info.str();
+            snapshots.publish();
+        }
 
-        sf::View view(center, sf::Vector2f(window.getSize().x, window.getSize().y));
-        view.setCenter(viewCenter);
-        view.setSize(window.getSize().x / zoom, window.getSize().y / zoom);
-        window.setView(view);
+        void render(sf::RenderWindow& window, const FrameInfo& frame) override {
+            const OrbitSnapshot& snap = snapshots.acquire();
+            if (snap.sequence == 0) return; // nothing published yet
+
+            // One trail point per new snapshot; N-body orbits precess, so keep
+            // much more. The coarse copy keeps every TRAIL_DECIMATION-th point
+            // over the same span of time.
+            if (snap.modeChanges != trailModeChanges || trails.trails() == 0) {
+                const std::size_t capacity = snap.nbodyMode ? NBODY_TRAIL_POINTS : KINEMATIC_TRAIL_POINTS;
+                trails.reset(planetTable.size(), capacity);
+                coarseTrails.reset(planetTable.size(), capacity / TRAIL_DECIMATION);
+                trailPushes = 0;
+                trailModeChanges = snap.modeChanges;
+            }
+            if (snap.sequence != drawnSequence) {
+                const bool coarse = trailPushes++ % TRAIL_DECIMATION == 0;
+                for (size_t i = 0; i < planetTable.size(); ++i) {
+                    trails.push(i, snap.trail[i], planetTable[i].baseColor);
+                    if (coarse) coarseTrails.push(i, snap.trail[i], planetTable[i].baseColor);
+                }
+                drawnSequence = snap.sequence;
+            }
 
-        window.clear(sf::Color(5, 5, 15));
+            sf::View view(center, sf::Vector2f(window.getSize().x, window.getSize().y));
+            view.setCenter(snap.viewCenter);
+            view.setSize(window.getSize().x / snap.zoom, window.getSize().y / snap.zoom);
+            window.setView(view);
+
+            // Draw Stars
+            starTime += frame.seconds;
+            starField.setTime(starTime);
+            window.draw(starField);
+            points.clear();
+
+            // Draw sun
+            if (circleVisible(snap.view, snap.sun.x, snap.sun.y, SUN_RADIUS)) {
+                sunSprite.setPosition(snap.sun);
+                if (SUN_RADIUS * snap.zoom >= SPRITE_PIXELS && bindTexture(sunSprite, textureFiles[0], SUN_RADIUS)) {
+                    window.draw(sunSprite);
+                }
+                else {
+                    // fallback sun as circle
+                    sunFallback.setPosition(snap.sun);
+                    window.draw(sunFallback);
+                }
+            }
 
-        // Draw Stars
-        for (auto& star : stars) {
-            window.draw(star.shape);
-        }
+            // Draw trails straight from their ring buffers
+            window.draw(snap.zoom < COARSE_TRAIL_ZOOM ? coarseTrails : trails);
 
-        // Draw sun
-        if (sunSprite.getTexture() != nullptr) {
-            window.draw(sunSprite);
-        }
-        else {
-            // fallback sun as circle
-            sf::CircleShape sunFallback(60.f);
-            sunFallback.setOrigin(60.f, 60.f);
-            sunFallback.setPosition(viewCenter);
-            sunFallback.setFillColor(sf::Color(255, 255, 100));
-            window.draw(sunFallback);
-        }
+            // Draw asteroids: sub-pixel ones as points, the rest in one batch
+            asteroidBatch.clear();
+            for (std::size_t i = 0; i < snap.asteroidX.size(); ++i) {
+                const float x = snap.asteroidX[i], y = snap.asteroidY[i], r = snap.asteroidR[i];
+                if (r * snap.zoom < POINT_PIXELS)
+                    addPoint(x, y, r * snap.zoom, ASTEROID_COLOR);
+                else
+                    asteroidBatch.add(x, y, r, ASTEROID_COLOR);
+            }
+            if (asteroidBatch.size() > 0) {
+                asteroidBatch.upload();
+                window.draw(asteroidBatch);
+            }
 
-        // Draw trails and planets
-        for (size_t i = 0; i < planets.size(); ++i) {
-            const auto& p = planets[i];
-
-            // Draw trail
-            if (p.trail.size() > 1) {
-                sf::VertexArray trail(sf::LineStrip, p.trail.size());
-                for (size_t j = 0; j < p.trail.size(); ++j) {
-                    trail[j].position = p.trail[j];
-                    sf::Color c = p.baseColor;
-                    c.a = static_cast<sf::Uint8>(255 * j / p.trail.size());
-                    trail[j].color = c;
+            // Draw planets
+            for (size_t i = 0; i < planetTable.size(); ++i) {
+                const sf::Vector2f pos = snap.planets[i];
+                const float radius = planetTable[i].radius;
+                if (!circleVisible(snap.view, pos.x, pos.y, radius)) continue;
+                const float pixels = radius * snap.zoom;
+                if (pixels < POINT_PIXELS) {
+                    addPoint(pos.x, pos.y, pixels, planetTable[i].baseColor);
+                }
+                else if (pixels >= SPRITE_PIXELS && bindTexture(planetSprites[i], textureFiles[i + 1], radius)) {
+                    planetSprites[i].setPosition(pos);
+                    window.draw(planetSprites[i]);
+                }
+                else {
+                    placeholder.setRadius(radius);
+                    placeholder.setOrigin(radius, radius);
+                    placeholder.setPosition(pos);
+                    placeholder.setFillColor(planetTable[i].baseColor);
+                    window.draw(placeholder);
                 }
-                window.draw(trail);
             }
+            if (!points.empty())
+                window.draw(points.data(), points.size(), sf::Points);
 
-            // Draw planet sprite at current position
-            sf::Vector2f pos = p.getPosition(viewCenter.x, viewCenter.y);
-            planetSprites[i].setPosition(pos);
-            window.draw(planetSprites[i]);
+            // Reset view to default for UI
+            window.setView(window.getDefaultView());
+            infoText.setString(snap.info);
+            window.draw(infoText);
         }
 
-        // Reset view to default for UI
-        window.setView(window.getDefaultView());
+    private:
+        // What render() draws, written by update()
+        struct OrbitSnapshot {
+            std::uint64_t sequence = 0;   // 0 = not yet published
+            unsigned modeChanges = 0;     // G presses so far; trails restart on a change
+            bool nbodyMode = false;
+            sf::Vector2f viewCenter;
+            float zoom = 1.f;
+            sf::FloatRect view;           // world rect on screen; only asteroids in it are listed
+            sf::Vector2f sun;
+            std::vector<sf::Vector2f> planets, trail; // drawn position, trail point
+            std::vector<float> asteroidX, asteroidY, asteroidR;
+            std::string info;
+        };
+
+        // Sizes a sprite to the given radius once its texture is ready
+        static bool bindTexture(sf::Sprite& sprite, const std::string& file, float radius) {
+            if (sprite.getTexture() != nullptr) return true;
+            const sf::Texture* tex = assets().texture(file);
+            if (tex == nullptr) return false;
+            sprite.setTexture(*tex, true);
+            sf::Vector2u size = tex->getSize();
+            sprite.setOrigin(size.x / 2.f, size.y / 2.f);
+            float scale = (radius * 2.f) / size.x;
+            sprite.setScale(scale, scale);
+            return true;
+        }
 
+        // A pixel for a body of screen radius pixels < 1, dimmed by its
+        // share of the pixel
+        void addPoint(float x, float y, float pixels, sf::Color color) {
+            color.a = static_cast<sf::Uint8>(color.a * std::clamp(2.f * pixels, 0.25f, 1.f));
+            points.emplace_back(sf::Vector2f(x, y), color);
+        }
 
-        infoText.setString(
-            "Middle mouse drag: Pan view\n"
-            "Mouse wheel: Zoom\n"
-        );
-        window.draw(infoText);
+        // Set by start(), then read-only on both threads; render() takes
+        // radii and colours from planetTable, never the stepped copies
+        sf::Vector2f screen, center;
+        const std::vector<Planet> planetTable = makePlanets();
+        std::vector<std::string> textureFiles;
+
+        // Simulation thread
+        std::vector<Planet> planets = planetTable;
+        // Gravitational N-body mode (G to toggle), forces on all cores
+        bool nbodyMode = false;
+        unsigned modeChanges = 0;
+        IntegratorKind integrator = IntegratorKind::VelocityVerlet;
+        NBodyWorld nbody;
+        float asteroidRadius = 0.f; // largest, for the culling margin
+        std::vector<int> inView;    // tree query scratch
+        JobSystem* pool = nullptr;
+        // Exact GPU forces (C to toggle), kept across G so the shader builds once
+        std::unique_ptr<GpuNBodyForces> gpuForces;
+        bool useGpu = false;
+        float forceMs = 0.f;
+        float zoom = 1.f;
+        sf::Vector2f viewCenter;
+        bool dragging = false;
+        sf::Vector2i lastMousePos;
+        std::uint64_t published = 0;
+
+        TripleBuffer<OrbitSnapshot> snapshots;
+
+        // Main thread
+        StarField starField;
+        float starTime = 0.f; // render clock for the twinkle
+        TrailRing trails, coarseTrails;
+        std::size_t trailPushes = 0;
+        unsigned trailModeChanges = 0;
+        std::uint64_t drawnSequence = 0;
+        sf::Sprite sunSprite;
+        std::vector<sf::Sprite> planetSprites;
+        sf::CircleShape placeholder;
+        sf::CircleShape sunFallback;
+        CircleBatch asteroidBatch;
+        std::vector<sf::Vertex> points; // sub-pixel bodies this frame
+        sf::Text infoText;
+    };
+}
 
-        window.display();
-    }
+void runOrbitSimulation() {
+    OrbitScene scene;
+    runSimulation(scene);
 }
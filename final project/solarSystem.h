@@ -0,0 +1,44 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+
+struct Star {
+    sf::Vector2f position;
+    float size;         // radius in pixels
+    float twinkleSpeed; // rad/s
+    float twinklePhase; // rad
+};
+
+// count stars scattered uniformly over area.
+std::vector<Star> generateStars(int count, sf::FloatRect area, unsigned seed);
+
+struct Planet {
+    std::string name;
+    float orbitRadius;        // in pixels (scaled)
+    float orbitPeriod;        // days
+    float radius;             // pixels (used for scaling texture)
+    sf::Color baseColor;      // trail colour, and the placeholder until the texture loads
+    // Double: a slow outer planet turns ~1e-4 rad per step, which a float
+    // angle near 2 pi would round by several percent
+    double currentOrbitAngle;  // radians
+    double previousOrbitAngle; // angle before the last step, for render interpolation
+    float massRatio;          // planet mass / sun mass, for the N-body mode
+
+    Planet(const std::string& n, float orbitR, float orbitP, float r, sf::Color c, float mRatio = 0.f)
+        : name(n), orbitRadius(orbitR), orbitPeriod(orbitP), radius(r), baseColor(c), currentOrbitAngle(0), previousOrbitAngle(0), massRatio(mRatio)
+    {
+    }
+
+    void update(double elapsedSeconds);
+    sf::Vector2f getPosition(float cx, float cy, float alpha = 1.f) const;
+};
+
+// Mercury to Neptune with scaled orbit radii and real periods.
+std::vector<Planet> makePlanets();
+
+// Gravitational parameter of the sun (px^3/s^2) that gives Earth's orbit
+// the same period as the kinematic view.
+float sunGravitationalParameter();
+
+void runOrbitSimulation();
@@ -0,0 +1,172 @@
+#include "spatialGrid.h"
+#include "jobSystem.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    constexpr int MAX_GRID_DIM = 4096;
+
+    inline bool aabbOverlap(const float* x, const float* y, const float* r, int a, int b) {
+        float reach = r[a] + r[b];
+        return std::fabs(x[a] - x[b]) < reach && std::fabs(y[a] - y[b]) < reach;
+    }
+}
+
+int SpatialGrid::cellIndex(float px, float py) const {
+    // Clamping keeps bodies that escaped the area in the edge cells; it is
+    // monotone, so neighbours stay at most one cell apart.
+    int cx = static_cast<int>((px - area.left) * invCell);
+    int cy = static_cast<int>((py - area.top) * invCell);
+    cx = std::clamp(cx, 0, cols - 1);
+    cy = std::clamp(cy, 0, rows - 1);
+    return cy * cols + cx;
+}
+
+void SpatialGrid::build(const float* x, const float* y, int count,
+    float cellSize, const sf::FloatRect& worldArea) {
+    area = worldArea;
+    cellSize = std::max({ cellSize, area.width / MAX_GRID_DIM, area.height / MAX_GRID_DIM, 1e-3f });
+    invCell = 1.f / cellSize;
+    cols = std::max(1, static_cast<int>(std::ceil(area.width * invCell)));
+    rows = std::max(1, static_cast<int>(std::ceil(area.height * invCell)));
+
+    const int cells = cols * rows;
+    cellStart.assign(cells + 1, 0);
+    cellOf.resize(count);
+    sorted.resize(count);
+
+    // Counting sort: histogram, exclusive prefix sum, scatter
+    for (int i = 0; i < count; ++i) {
+        cellOf[i] = cellIndex(x[i], y[i]);
+        ++cellStart[cellOf[i] + 1];
+    }
+    for (int c = 0; c < cells; ++c)
+        cellStart[c + 1] += cellStart[c];
+    for (int i = 0; i < count; ++i)
+        sorted[cellStart[cellOf[i]]++] = i;
+    // The scatter advanced every start to the next cell's start; shift back.
+    for (int c = cells; c > 0; --c)
+        cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+}
+
+void SpatialGrid::findPairsInRows(int rowBegin, int rowEnd, const float* x, const float* y,
+    const float* r, std::vector<BodyPair>& out, std::size_t& tested) const {
+    // Half neighbourhood (E, SW, S, SE) so every cell pair is visited once
+    static constexpr int NX[4] = { 1, -1, 0, 1 };
+    static constexpr int NY[4] = { 0, 1, 1, 1 };
+
+    for (int cy = rowBegin; cy < rowEnd; ++cy) {
+        for (int cx = 0; cx < cols; ++cx) {
+            const int c = cy * cols + cx;
+            const int begin = cellStart[c], end = cellStart[c + 1];
+            for (int s = begin; s < end; ++s) {
+                const int a = sorted[s];
+                for (int t = s + 1; t < end; ++t) {
+                    const int b = sorted[t];
+                    ++tested;
+                    if (aabbOverlap(x, y, r, a, b))
+                        out.push_back({ std::min(a, b), std::max(a, b) });
+                }
+                for (int k = 0; k < 4; ++k) {
+                    const int nx = cx + NX[k], ny = cy + NY[k];
+                    if (nx < 0 || nx >= cols || ny >= rows) continue;
+                    const int n = ny * cols + nx;
+                    for (int t = cellStart[n]; t < cellStart[n + 1]; ++t) {
+                        const int b = sorted[t];
+                        ++tested;
+                        if (aabbOverlap(x, y, r, a, b))
+                            out.push_back({ std::min(a, b), std::max(a, b) });
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SpatialGrid::findPairs(const float* x, const float* y, const float* r,
+    std::vector<BodyPair>& out, BroadphaseStats& stats) const {
+    out.clear();
+    stats = {};
+    findPairsInRows(0, rows, x, y, r, out, stats.testedPairs);
+    stats.candidatePairs = out.size();
+}
+
+void SpatialGrid::findPairs(const float* x, const float* y, const float* r,
+    std::vector<BodyPair>& out, BroadphaseStats& stats, JobSystem& pool) {
+    slotPairs.resize(pool.slotCount());
+    slotTested.assign(pool.slotCount(), 0);
+    pool.parallelFor(0, rows, [&](int slot, int rowBegin, int rowEnd) {
+        slotPairs[slot].clear();
+        findPairsInRows(rowBegin, rowEnd, x, y, r, slotPairs[slot], slotTested[slot]);
+    });
+
+    // Concatenate in slot (= row) order
+    out.clear();
+    stats = {};
+    for (std::size_t s = 0; s < slotPairs.size(); ++s) {
+        out.insert(out.end(), slotPairs[s].begin(), slotPairs[s].end());
+        stats.testedPairs += slotTested[s];
+        slotPairs[s].clear();
+    }
+    stats.candidatePairs = out.size();
+}
+
+void bruteForcePairs(const float* x, const float* y, const float* r, int count,
+    std::vector<BodyPair>& out, BroadphaseStats& stats) {
+    out.clear();
+    stats = {};
+    for (int i = 0; i < count; ++i) {
+        for (int j = i + 1; j < count; ++j) {
+            ++stats.testedPairs;
+            if (aabbOverlap(x, y, r, i, j))
+                out.push_back({ i, j });
+        }
+    }
+    stats.candidatePairs = out.size();
+}
+
+void SpatialGrid::findAwakePairs(const float* x, const float* y, const float* r, const char* asleep,
+    std::vector<BodyPair>& out, BroadphaseStats& stats) const {
+    out.clear();
+    stats.testedPairs = 0;
+    const int count = static_cast<int>(cellOf.size());
+    for (int a = 0; a < count; ++a) {
+        if (asleep[a]) continue;
+        const int cx = cellOf[a] % cols, cy = cellOf[a] / cols;
+        for (int ny = std::max(cy - 1, 0); ny <= std::min(cy + 1, rows - 1); ++ny) {
+            for (int nx = std::max(cx - 1, 0); nx <= std::min(cx + 1, cols - 1); ++nx) {
+                const int n = ny * cols + nx;
+                for (int t = cellStart[n]; t < cellStart[n + 1]; ++t) {
+                    const int b = sorted[t];
+                    // Awake-awake pairs are found from both ends; keep one
+                    if (b == a || (!asleep[b] && b < a)) continue;
+                    ++stats.testedPairs;
+                    if (aabbOverlap(x, y, r, a, b))
+                        out.push_back({ std::min(a, b), std::max(a, b) });
+                }
+            }
+        }
+    }
+    stats.candidatePairs = out.size();
+}
+
+void SpatialGrid::query(const sf::FloatRect& rect, std::vector<int>& out) const {
+    if (cols == 0) return;
+    const int first = cellIndex(rect.left, rect.top);
+    const int last = cellIndex(rect.left + rect.width, rect.top + rect.height);
+    const int cx0 = first % cols, cy0 = first / cols;
+    const int cx1 = last % cols, cy1 = last / cols;
+    for (int cy = cy0; cy <= cy1; ++cy) {
+        for (int cx = cx0; cx <= cx1; ++cx) {
+            const int c = cy * cols + cx;
+            out.insert(out.end(), sorted.begin() + cellStart[c], sorted.begin() + cellStart[c + 1]);
+        }
+    }
+}
+
+std::size_t SpatialGrid::memoryBytes() const {
+    std::size_t bytes = capacityBytes(cellStart, cellOf, sorted, slotTested);
+    for (const auto& slot : slotPairs) bytes += capacityBytes(slot);
+    return bytes;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+#include "memoryUsage.h"
+
+class JobSystem;
+
+// Candidate pair handed from the broadphase to the narrowphase (a < b).
+struct BodyPair {
+    int a;
+    int b;
+};
+
+enum class BroadphaseMode { Grid, BruteForce };
+
+struct BroadphaseStats {
+    std::size_t testedPairs = 0;    // AABB tests performed
+    std::size_t candidatePairs = 0; // pairs whose AABBs overlap
+};
+
+// Uniform grid over a world rectangle, rebuilt every step with a counting sort.
+// The cell size must be >= the largest sum of two radii (2 * max radius), so
+// only the 3x3 neighbourhood of a cell can hold overlapping bodies.
+class SpatialGrid {
+public:
+    void build(const float* x, const float* y, int count,
+        float cellSize, const sf::FloatRect& area);
+
+    void findPairs(const float* x, const float* y, const float* r,
+        std::vector<BodyPair>& out, BroadphaseStats& stats) const;
+    // Same pairs in the same order, with rows split across the pool.
+    void findPairs(const float* x, const float* y, const float* r,
+        std::vector<BodyPair>& out, BroadphaseStats& stats, JobSystem& pool);
+    // Only pairs with at least one awake body, searched from the awake
+    // bodies' neighbourhoods, so sleeping regions cost nothing.
+    void findAwakePairs(const float* x, const float* y, const float* r, const char* asleep,
+        std::vector<BodyPair>& out, BroadphaseStats& stats) const;
+
+    int columns() const { return cols; }
+    int rowCount() const { return rows; }
+    // Bodies indexed by the last build.
+    std::size_t bodyCount() const { return cellOf.size(); }
+    // Appends every body whose cell overlaps rect, as of the last build.
+    void query(const sf::FloatRect& rect, std::vector<int>& out) const;
+    std::size_t memoryBytes() const;
+
+private:
+    int cellIndex(float px, float py) const;
+    void findPairsInRows(int rowBegin, int rowEnd, const float* x, const float* y,
+        const float* r, std::vector<BodyPair>& out, std::size_t& tested) const;
+
+    sf::FloatRect area;
+    float invCell = 1.f;
+    int cols = 0, rows = 0;
+    std::vector<int> cellStart; // cols * rows + 1 offsets into sorted
+    std::vector<int> cellOf;    // cell of every body
+    std::vector<int> sorted;    // body indices grouped by cell
+
+    // Per-slot output of the parallel search, kept to reuse capacity
+    std::vector<std::vector<BodyPair>> slotPairs;
+    std::vector<std::size_t> slotTested;
+};
+
+// Reference O(n^2) broadphase producing the same candidate set as SpatialGrid.
+void bruteForcePairs(const float* x, const float* y, const float* r, int count,
+    std::vector<BodyPair>& out, BroadphaseStats& stats);
@@ -0,0 +1,140 @@
+#include "starField.h"
+#include <algorithm>
+#include <cmath>
+#include "sceneConfig.h"
+#include "solarSystem.h"
+
+namespace {
+    // Ranges the vertex colour channels are scaled to; the shader spells
+    // out the same numbers
+    constexpr float MIN_TWINKLE_SPEED = 0.5f, MAX_TWINKLE_SPEED = 2.f; // rad/s
+    constexpr float MAX_RADIUS = 4.f;                                  // px
+
+    // Colour channels carry the star: r = twinkle phase, g = twinkle speed,
+    // b = radius in pixels, a = brightness. texCoords hold the quad corner.
+    const char* const STAR_VERTEX_SHADER = R"(
+        uniform float time;
+        uniform vec2 pixelSize; // one pixel in clip space
+        void main() {
+            float radius = gl_Color.b * 4.0;
+            float phase = gl_Color.r * 6.2831853;
+            float speed = mix(0.5, 2.0, gl_Color.g);
+            vec2 corner = gl_MultiTexCoord0.xy * (radius + 1.0);
+            vec4 centre = gl_ModelViewProjectionMatrix * gl_Vertex;
+            gl_Position = centre + vec4(corner * pixelSize * centre.w, 0.0, 0.0);
+            gl_TexCoord[0] = vec4(corner, radius, 0.0);
+            float twinkle = 0.65 + 0.35 * sin(time * speed + phase);
+            gl_FrontColor = vec4(1.0, 1.0, 1.0, gl_Color.a * twinkle);
+        }
+    )";
+    // Disc with one pixel of falloff at the rim
+    const char* const STAR_FRAGMENT_SHADER = R"(
+        void main() {
+            float d = length(gl_TexCoord[0].xy);
+            float coverage = clamp(gl_TexCoord[0].z + 0.5 - d, 0.0, 1.0);
+            gl_FragColor = vec4(gl_Color.rgb, gl_Color.a * coverage);
+        }
+    )";
+
+    // Shared twinkle shader, or nullptr when the driver has no shader support.
+    sf::Shader* starShader() {
+        static sf::Shader shader;
+        static bool loaded = sf::Shader::isAvailable()
+            && shader.loadFromMemory(STAR_VERTEX_SHADER, STAR_FRAGMENT_SHADER);
+        return loaded ? &shader : nullptr;
+    }
+
+    sf::Uint8 unitToByte(float v) {
+        return static_cast<sf::Uint8>(std::clamp(v, 0.f, 1.f) * 255.f + 0.5f);
+    }
+}
+
+StarField::StarField()
+    : buffer(sf::Triangles, sf::VertexBuffer::Static),
+    useShader(sf::VertexBuffer::isAvailable() && starShader() != nullptr)
+{
+}
+
+void StarField::build(const std::vector<Star>& stars) {
+    count = stars.size();
+    if (useShader) {
+        // Counting sort into tiles
+        float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f;
+        for (std::size_t i = 0; i < count; ++i) {
+            const sf::Vector2f p = stars[i].position;
+            if (i == 0) { minX = maxX = p.x; minY = maxY = p.y; }
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        bounds = sf::FloatRect(minX, minY, std::max(maxX - minX, 1.f), std::max(maxY - minY, 1.f));
+        std::vector<int> tileOf(count);
+        tileStart.assign(TILES * TILES + 1, 0);
+        for (std::size_t i = 0; i < count; ++i) {
+            const sf::Vector2f p = stars[i].position;
+            const int tx = std::min(TILES - 1, static_cast<int>((p.x - bounds.left) / bounds.width * TILES));
+            const int ty = std::min(TILES - 1, static_cast<int>((p.y - bounds.top) / bounds.height * TILES));
+            tileOf[i] = ty * TILES + tx;
+            ++tileStart[tileOf[i] + 1];
+        }
+        for (int t = 0; t < TILES * TILES; ++t)
+            tileStart[t + 1] += tileStart[t];
+        std::vector<std::size_t> next(tileStart.begin(), tileStart.end() - 1);
+
+        static const sf::Vector2f corners[6] = {
+            { -1.f, -1.f }, { 1.f, -1.f }, { 1.f, 1.f },
+            { -1.f, -1.f }, { 1.f, 1.f }, { -1.f, 1.f } };
+        std::vector<sf::Vertex> vertices(count * 6);
+        for (std::size_t i = 0; i < count; ++i) {
+            const Star& s = stars[i];
+            const std::size_t slot = next[tileOf[i]]++;
+            const sf::Color packed(
+                unitToByte(s.twinklePhase / TWO_PI),
+                unitToByte((s.twinkleSpeed - MIN_TWINKLE_SPEED) / (MAX_TWINKLE_SPEED - MIN_TWINKLE_SPEED)),
+                unitToByte(s.size / MAX_RADIUS),
+                255);
+            for (int c = 0; c < 6; ++c)
+                vertices[slot * 6 + c] = sf::Vertex(s.position, packed, corners[c]);
+        }
+        useShader = count == 0 || (buffer.create(vertices.size()) && buffer.update(vertices.data()));
+        if (useShader) return;
+    }
+
+    // No buffer or shader support: plain discs that scale with the view
+    fallback.clear();
+    fallback.reserve(count);
+    for (const Star& s : stars)
+        fallback.add(s.position.x, s.position.y, s.size, sf::Color::White);
+    fallback.upload();
+}
+
+void StarField::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    if (count == 0) return;
+    if (!useShader) {
+        target.draw(fallback, states);
+        return;
+    }
+    sf::Shader* shader = starShader();
+    const sf::Vector2u pixels = target.getSize();
+    shader->setUniform("time", time);
+    shader->setUniform("pixelSize", sf::Glsl::Vec2(2.f / pixels.x, 2.f / pixels.y));
+    states.shader = shader;
+
+    // Tiles under the view, widened by the largest star's screen radius
+    const sf::View& view = target.getView();
+    const float margin = (MAX_RADIUS + 1.f) * view.getSize().x / pixels.x;
+    const sf::Vector2f lo = view.getCenter() - view.getSize() / 2.f - sf::Vector2f(margin, margin);
+    const sf::Vector2f hi = view.getCenter() + view.getSize() / 2.f + sf::Vector2f(margin, margin);
+    auto tile = [](float v, float start, float length) {
+        return static_cast<int>(std::floor((v - start) / length * TILES));
+    };
+    const int x0 = std::max(0, tile(lo.x, bounds.left, bounds.width));
+    const int x1 = std::min(TILES - 1, tile(hi.x, bounds.left, bounds.width));
+    const int y0 = std::max(0, tile(lo.y, bounds.top, bounds.height));
+    const int y1 = std::min(TILES - 1, tile(hi.y, bounds.top, bounds.height));
+    for (int ty = y0; ty <= y1 && x0 <= x1; ++ty) {
+        // Tiles of a row are consecutive in the buffer
+        const std::size_t first = tileStart[ty * TILES + x0], last = tileStart[ty * TILES + x1 + 1];
+        if (last > first)
+            target.draw(buffer, first * 6, (last - first) * 6, states);
+    }
+}
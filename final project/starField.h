@@ -0,0 +1,40 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+#include "circleBatch.h"
+
+struct Star;
+
+// Background stars baked once into a static vertex buffer and drawn with a
+// single call. Each star is a quad whose corners all sit on its centre; the
+// vertex shader pushes them out to a fixed size in pixels, so stars stay
+// crisp at any zoom, and animates the twinkle from the phase and speed
+// stored in the vertex colour. Stars are stored tile by tile, so only the
+// tiles under the target's view are drawn, one call per row of tiles; per
+// frame the CPU sets two uniforms and picks the ranges. Without shader
+// support the stars are drawn as static world-space discs, all of them.
+class StarField : public sf::Drawable {
+public:
+    StarField();
+
+    // Uploads the stars; the CPU side keeps nothing once the buffer holds them.
+    void build(const std::vector<Star>& stars);
+    // Drives the twinkle; any monotonic clock in seconds.
+    void setTime(float seconds) { time = seconds; }
+
+    std::size_t size() const { return count; }
+
+private:
+    static constexpr int TILES = 16; // per side
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    sf::VertexBuffer buffer;
+    sf::FloatRect bounds;                // covers every star
+    std::vector<std::size_t> tileStart;  // first star of each tile, row-major, plus the end
+    CircleBatch fallback{ sf::VertexBuffer::Static };
+    std::size_t count = 0;
+    float time = 0.f;
+    bool useShader;
+};
@@ -0,0 +1,143 @@
+#include "telemetry.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include "frameArena.h"
+#include "heapCounter.h"
+
+namespace {
+    constexpr std::size_t MAX_LINE = 512;
+    constexpr auto RECONNECT_INTERVAL = std::chrono::seconds(1);
+}
+
+Telemetry::~Telemetry() {
+    if (!active()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    sender.join();
+}
+
+bool Telemetry::start(const std::string& target, float hz) {
+    // protocol:host:port
+    const auto first = target.find(':'), last = target.rfind(':');
+    const std::string scheme = target.substr(0, first);
+    if (first == std::string::npos || first == last || (scheme != "udp" && scheme != "tcp") || hz <= 0.f) {
+        std::cerr << "Bad telemetry target " << target << ", expected udp:host:port or tcp:host:port\n";
+        return false;
+    }
+    int portNumber = 0;
+    try {
+        portNumber = std::stoi(target.substr(last + 1));
+    }
+    catch (const std::exception&) {
+    }
+    address = sf::IpAddress(target.substr(first + 1, last - first - 1));
+    if (portNumber <= 0 || portNumber > 65535 || address == sf::IpAddress::None) {
+        std::cerr << "Cannot resolve telemetry target " << target << "\n";
+        return false;
+    }
+    protocol = scheme == "udp" ? Protocol::Udp : Protocol::Tcp;
+    port = static_cast<unsigned short>(portNumber);
+    period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+
+    periodStart = nextDue = Clock::now();
+    periodSteps = steps;
+    periodAllocations = heapAllocations();
+    lastConnectAttempt = periodStart - RECONNECT_INTERVAL;
+    sender = std::thread(&Telemetry::run, this);
+    return true;
+}
+
+bool Telemetry::afterStep() {
+    ++steps;
+    return active() && Clock::now() >= nextDue;
+}
+
+TelemetrySample& Telemetry::next() {
+    // The slot still holds whatever it carried two samples ago
+    TelemetrySample& s = samples.back();
+    s = TelemetrySample();
+    return s;
+}
+
+void Telemetry::publish() {
+    const Clock::time_point now = Clock::now();
+    const std::uint64_t allocations = heapAllocations();
+    const std::uint64_t periodLength = steps - periodSteps;
+    TelemetrySample& s = samples.back();
+    s.step = steps;
+    if (periodLength > 0) {
+        s.stepMs = std::chrono::duration<double, std::milli>(now - periodStart).count() / periodLength;
+        s.heapAllocsPerStep = double(allocations - periodAllocations) / periodLength;
+    }
+    s.arenaHighWater = frameArena().highWater();
+    samples.publish();
+
+    periodStart = now;
+    periodSteps = steps;
+    periodAllocations = allocations;
+    nextDue = now + period;
+}
+
+std::size_t Telemetry::formatLine(const TelemetrySample& s, char* out, std::size_t size) {
+    // snprintf into a fixed buffer, so sending never touches the heap
+    // counters the samples report
+    std::size_t n = 0;
+    auto put = [&](auto... args) {
+        if (n >= size) return;
+        const int written = std::snprintf(out + n, size - n, args...);
+        if (written > 0) n += static_cast<std::size_t>(written);
+    };
+    put("step=%llu step_ms=%.4f bodies=%zu", static_cast<unsigned long long>(s.step), s.stepMs, s.bodies);
+    if (s.contacts != TelemetrySample::NONE) put(" contacts=%zu", s.contacts);
+    if (s.sleeping != TelemetrySample::NONE) put(" sleeping=%zu", s.sleeping);
+    if (!std::isnan(s.energy)) put(" energy=%.9g", s.energy);
+    if (!std::isnan(s.energyDrift)) put(" energy_drift=%.6g", s.energyDrift);
+    put(" heap_allocs_per_step=%g arena_high_water=%zu\n", s.heapAllocsPerStep, s.arenaHighWater);
+    if (n >= size) {
+        // Truncated: keep the line terminated
+        n = size - 1;
+        out[n - 1] = '\n';
+    }
+    return n;
+}
+
+void Telemetry::run() {
+    std::uint64_t sentStep = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        const bool stop = wake.wait_for(lock, period, [&] { return stopping; });
+        lock.unlock();
+        // The final sample is still sent on the way out
+        const TelemetrySample& s = samples.acquire();
+        if (s.step != sentStep) {
+            send(s);
+            sentStep = s.step;
+        }
+        if (stop) return;
+        lock.lock();
+    }
+}
+
+void Telemetry::send(const TelemetrySample& s) {
+    char line[MAX_LINE];
+    const std::size_t length = formatLine(s, line, sizeof line);
+    if (protocol == Protocol::Udp) {
+        udp.send(line, length, address, port);
+        return;
+    }
+    if (!connected) {
+        const Clock::time_point now = Clock::now();
+        if (now - lastConnectAttempt < RECONNECT_INTERVAL) return;
+        lastConnectAttempt = now;
+        connected = tcp.connect(address, port, sf::seconds(1.f)) == sf::Socket::Done;
+        if (!connected) return;
+    }
+    if (tcp.send(line, length) != sf::Socket::Done) {
+        tcp.disconnect();
+        connected = false;
+    }
+}
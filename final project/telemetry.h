@@ -0,0 +1,89 @@
+#pragma once
+#include <SFML/Network.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "tripleBuffer.h"
+
+// One reading of a running simulation. Fields a scene cannot measure keep
+// their NONE / NaN defaults and are left out of the line.
+struct TelemetrySample {
+    static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+    std::uint64_t step = 0;           // steps run so far
+    double stepMs = 0.0;              // mean wall time per step since the previous sample
+    std::size_t bodies = 0;
+    std::size_t contacts = NONE;
+    std::size_t sleeping = NONE;
+    double energy = std::numeric_limits<double>::quiet_NaN();
+    double energyDrift = std::numeric_limits<double>::quiet_NaN(); // (energy - start) / |start|
+    double heapAllocsPerStep = 0.0;   // every thread, since the previous sample
+    std::size_t arenaHighWater = 0;   // step arena peak of the stepping thread, bytes
+};
+
+// Streams samples of a run to a dashboard at a fixed rate. The stepping
+// thread calls afterStep() after every step; when it returns true, at most
+// rate times a second, it fills next() and publish()es it through a
+// TripleBuffer. A sender thread of its own sends the newest sample it has
+// not sent yet and drops any it never got to, so a slow or absent listener
+// never holds up the simulation.
+//
+// A target of "udp:host:port" sends one datagram per sample,
+// "tcp:host:port" connects out and writes one line per sample, reconnecting
+// at most once a second while the listener is away. Either way a sample is
+// a line of key=value pairs, like the headless summary.
+class Telemetry {
+public:
+    Telemetry() = default;
+    ~Telemetry();
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    // Starts the sender; prints why and returns false for a bad target.
+    bool start(const std::string& target, float hz);
+    bool active() const { return sender.joinable(); }
+
+    // Stepping thread only.
+    bool afterStep();
+    TelemetrySample& next();
+    void publish();
+
+    // Formats s as a newline-terminated line into out; returns its length.
+    static std::size_t formatLine(const TelemetrySample& s, char* out, std::size_t size);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    enum class Protocol { Udp, Tcp };
+
+    void run();
+    void send(const TelemetrySample& s);
+
+    // Set by start()
+    Protocol protocol = Protocol::Udp;
+    sf::IpAddress address;
+    unsigned short port = 0;
+    Clock::duration period{};
+
+    // Stepping thread
+    TripleBuffer<TelemetrySample> samples;
+    std::uint64_t steps = 0, periodSteps = 0;
+    std::uint64_t periodAllocations = 0;
+    Clock::time_point periodStart, nextDue;
+
+    // Sender thread
+    sf::UdpSocket udp;
+    sf::TcpSocket tcp;
+    bool connected = false;
+    Clock::time_point lastConnectAttempt;
+
+    std::thread sender;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
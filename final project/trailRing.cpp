@@ -0,0 +1,97 @@
+#include "trailRing.h"
+#include <algorithm>
+
+namespace {
+    // Alpha rises linearly from the oldest point (start) to the newest.
+    const char* const TRAIL_VERTEX_SHADER = R"(
+        uniform float start;
+        uniform float count;
+        void main() {
+            gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+            float fade = (gl_MultiTexCoord0.x - start) / count;
+            gl_FrontColor = vec4(gl_Color.rgb, gl_Color.a * fade);
+        }
+    )";
+    const char* const TRAIL_FRAGMENT_SHADER = R"(
+        void main() {
+            gl_FragColor = gl_Color;
+        }
+    )";
+
+    // Shared fade shader, or nullptr when the driver has no shader support.
+    sf::Shader* trailShader() {
+        static sf::Shader shader;
+        static bool loaded = sf::Shader::isAvailable()
+            && shader.loadFromMemory(TRAIL_VERTEX_SHADER, TRAIL_FRAGMENT_SHADER);
+        return loaded ? &shader : nullptr;
+    }
+}
+
+TrailRing::TrailRing()
+    : buffer(sf::LineStrip, sf::VertexBuffer::Dynamic), useBuffer(sf::VertexBuffer::isAvailable())
+{
+}
+
+void TrailRing::reset(std::size_t trails, std::size_t capacity) {
+    cap = capacity;
+    rings.assign(trails, Ring{});
+    vertices.assign(trails * 2 * cap, sf::Vertex());
+    for (std::size_t i = 0; i < vertices.size(); ++i)
+        vertices[i].texCoords.x = static_cast<float>(i % (2 * cap));
+    if (useBuffer && !vertices.empty())
+        useBuffer = buffer.create(vertices.size()) && buffer.update(vertices.data());
+    useBuffer = useBuffer && trailShader() != nullptr;
+}
+
+void TrailRing::clear() {
+    for (auto& ring : rings) ring = Ring{};
+}
+
+void TrailRing::push(std::size_t trail, sf::Vector2f position, sf::Color color) {
+    Ring& ring = rings[trail];
+    const std::size_t slot = trail * 2 * cap + ring.head;
+    sf::Vertex* lo = &vertices[slot];
+    sf::Vertex* hi = &vertices[slot + cap];
+    lo->position = hi->position = position;
+    lo->color = hi->color = color;
+    if (useBuffer) {
+        buffer.update(lo, 1, static_cast<unsigned>(slot));
+        buffer.update(hi, 1, static_cast<unsigned>(slot + cap));
+    }
+    if (ring.count == 0) {
+        ring.minX = ring.maxX = position.x;
+        ring.minY = ring.maxY = position.y;
+    }
+    ring.minX = std::min(ring.minX, position.x); ring.maxX = std::max(ring.maxX, position.x);
+    ring.minY = std::min(ring.minY, position.y); ring.maxY = std::max(ring.maxY, position.y);
+    ring.head = (ring.head + 1) % cap;
+    ring.count = std::min(ring.count + 1, cap);
+}
+
+void TrailRing::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    sf::Shader* shader = useBuffer ? trailShader() : nullptr;
+    const sf::View& view = target.getView();
+    const sf::Vector2f lo = view.getCenter() - view.getSize() / 2.f;
+    const sf::Vector2f hi = view.getCenter() + view.getSize() / 2.f;
+    for (std::size_t t = 0; t < rings.size(); ++t) {
+        const Ring& ring = rings[t];
+        if (ring.count < 2) continue;
+        if (ring.maxX < lo.x || ring.minX > hi.x || ring.maxY < lo.y || ring.minY > hi.y) continue;
+        const std::size_t start = (ring.head + cap - ring.count) % cap;
+        const std::size_t first = t * 2 * cap + start;
+
+        if (shader) {
+            shader->setUniform("start", static_cast<float>(start));
+            shader->setUniform("count", static_cast<float>(ring.count));
+            states.shader = shader;
+            target.draw(buffer, first, ring.count, states);
+            continue;
+        }
+
+        // No buffer or shader support: fade a copy of the strip on the CPU
+        scratch.assign(vertices.begin() + first, vertices.begin() + first + ring.count);
+        for (std::size_t j = 0; j < scratch.size(); ++j)
+            scratch[j].color.a = static_cast<sf::Uint8>(scratch[j].color.a * j / ring.count);
+        target.draw(scratch.data(), scratch.size(), sf::LineStrip, states);
+    }
+}
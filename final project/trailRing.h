@@ -0,0 +1,43 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+// Fixed-capacity position trails, one ring per body, living in a persistent
+// vertex buffer. Each point is written twice, at slot i and i + capacity, so
+// the live trail is always one contiguous line strip whatever the head is.
+// Slot indices ride in texCoords.x; a vertex shader turns them into the fade
+// ramp, so pushing a point touches two vertices instead of the whole trail.
+// Each ring keeps a box around every point it has held since it was last
+// emptied, and trails whose box misses the target's view are not drawn.
+class TrailRing : public sf::Drawable {
+public:
+    TrailRing();
+
+    // Drops all points and resizes to `trails` rings of `capacity` points.
+    void reset(std::size_t trails, std::size_t capacity);
+    // Empties every ring, keeping capacity and buffer.
+    void clear();
+    // Appends a point to one trail, overwriting its oldest when full.
+    void push(std::size_t trail, sf::Vector2f position, sf::Color color);
+
+    std::size_t trails() const { return rings.size(); }
+    std::size_t capacity() const { return cap; }
+    std::size_t size(std::size_t trail) const { return rings[trail].count; }
+
+private:
+    struct Ring {
+        std::size_t head = 0;  // next slot to write, in [0, cap)
+        std::size_t count = 0;
+        float minX = 0.f, minY = 0.f, maxX = 0.f, maxY = 0.f; // valid once count > 0
+    };
+
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+    std::vector<Ring> rings;
+    std::vector<sf::Vertex> vertices;         // trails * 2 * cap, mirrors the GPU
+    mutable std::vector<sf::Vertex> scratch;  // fallback path: faded copy of one trail
+    sf::VertexBuffer buffer;
+    std::size_t cap = 0;
+    bool useBuffer;
+};
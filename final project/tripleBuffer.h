@@ -0,0 +1,35 @@
+#pragma once
+#include <atomic>
+
+// Lock-free hand-off of whole values from one producer thread to one
+// consumer thread. The producer fills back() and publish()es it; the
+// consumer's acquire() returns the newest published value and keeps
+// returning it until a newer one arrives. Three slots mean neither side
+// ever waits: the producer always has a free slot to write, and a slow
+// consumer just skips the values it never got to. Slots are reused, so
+// values holding vectors stop allocating once their capacity settles.
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer: the slot to fill; holds whatever it held two publishes ago.
+    T& back() { return slots[backIndex]; }
+    void publish() {
+        backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Consumer: the latest published value, default-constructed until the
+    // first publish().
+    const T& acquire() {
+        if (middle.load(std::memory_order_relaxed) & FRESH)
+            frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+        return slots[frontIndex];
+    }
+
+private:
+    static constexpr unsigned INDEX = 3, FRESH = 4;
+
+    T slots[3];
+    std::atomic<unsigned> middle{ 1 }; // slot index, plus FRESH once published
+    unsigned backIndex = 0;            // producer only
+    unsigned frontIndex = 2;           // consumer only
+};
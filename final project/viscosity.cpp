@@ -1,33 +1,163 @@
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
+#include <algorithm>
 #include <cmath>
 #include <vector>
+#include <fstream>
 #include <sstream>
 #include <iostream>
+#include "viscosity.h"
+#include "assets.h"
+#include "circleBatch.h"
+#include "frameArena.h"
+#include "sceneConfig.h"
+#include "simdKernels.h"
+#include "simulation.h"
+#include "jobSystem.h"
 
-static constexpr float PROJECTILE_GRAVITY = 500.f;
+static constexpr float BALL_RADIUS = 10.f;
+static constexpr float COLUMN_BALL_RADIUS = 2.f;
+static constexpr int COLUMN_BALLS = 1500;
 
-class PhysicsCircle {
-public:
-    sf::CircleShape shape;
-    sf::Vector2f velocity;
-    bool settled;
+const std::vector<Fluid>& defaultFluids() {
+    static const std::vector<Fluid> fluids{
+        { "Water", 5.f, sf::Color(64,164,223,180) },
+        { "Alcohol", 8.f, sf::Color(194,245,255,180) },
+        { "Oil", 15.f, sf::Color(255,222,89,180) },
+        { "Honey", 50.f, sf::Color(204,142,53,200) },
+        { "Glycerine", 30.f, sf::Color(230,230,255,200) }
+    };
+    return fluids;
+}
+
+bool loadFluids(const std::string& path, std::vector<Fluid>& out) {
+    out.clear();
+    std::ifstream in(path);
+    if (!in) return false;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#' || line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        std::istringstream row(line);
+        std::string name, field;
+        float values[5] = { 0.f, 0.f, 0.f, 0.f, 255.f }; // viscosity, r, g, b, a
+        int fields = 0;
+        std::getline(row, name, ',');
+        while (fields < 5 && std::getline(row, field, ',')) {
+            std::istringstream number(field);
+            if (!(number >> values[fields])) break;
+            ++fields;
+        }
+        if (name.empty() || fields < 4) {
+            std::cerr << path << ":" << lineNo << ": expected name,viscosity,r,g,b[,a]\n";
+            continue;
+        }
+        auto channel = [](float v) { return (sf::Uint8)std::min(std::max(v, 0.f), 255.f); };
+        out.push_back({ name, values[0],
+            sf::Color(channel(values[1]), channel(values[2]), channel(values[3]), channel(values[4])) });
+    }
+    return !out.empty();
+}
+
+int ViscosityWorld::addBall(float x, float y, float radius, float drag, float bottom) {
+    viscosity.push_back(drag);
+    containerBottom.push_back(bottom);
+    const int i = balls.add(x, y, radius);
+    sleep.resize(balls.size());
+    return i;
+}
+
+void ViscosityWorld::resetBall(int i, float x, float y) {
+    balls.x[i] = balls.prevX[i] = x;
+    balls.y[i] = balls.prevY[i] = y;
+    balls.vx[i] = balls.vy[i] = 0.f;
+    sleep.wake(i);
+}
+
+void ViscosityWorld::step(float dt) {
+    const int count = (int)balls.size();
+    simdKernels().dragFall(balls.y.data(), balls.vy.data(), viscosity.data(), sleep.sleepFlags(),
+        0, count, GRAVITY, dt);
+    for (int i = 0; i < count; ++i) {
+        if (!sleep.asleep(i)) {
+            float bottomY = containerBottom[i] - balls.radius[i];
+            if (balls.y[i] + balls.radius[i] >= bottomY) {
+                balls.y[i] = bottomY - balls.radius[i];
+                sleep.sleepNow(i, balls);
+            }
+        }
+    }
+}
+
+void ViscosityColumns::build(const std::vector<Fluid>& fluidTable, const std::vector<sf::FloatRect>& rects,
+    int ballsPerColumn, float radius, unsigned seed) {
+    fluids = fluidTable;
+    columns.assign(fluids.size(), CollisionWorld());
+    for (std::size_t c = 0; c < fluids.size(); ++c) {
+        CollisionWorld& w = columns[c];
+        w.bounds = rects[c];
+        w.config.gravity = GRAVITY;
+        w.config.dragModel = DragModel::Linear;
+        w.config.drag = fluids[c].viscosity;
+        w.config.restitution = 0.3f;
+        w.ccd = false; // terminal speeds stay far below a radius per step
+        // Each column gets its own stream so adding a fluid leaves the others unchanged
+        std::mt19937 rng(seed + (unsigned)c);
+        w.spawn(ballsPerColumn, radius, radius, rng);
+    }
+}
+
+void ViscosityColumns::step(float dt) {
+    auto stepColumns = [&](int, int b, int e) {
+        for (int c = b; c < e; ++c) {
+            columns[c].balls.savePrevious();
+            columns[c].step(dt);
+        }
+    };
+    if (pool) pool->parallelFor(0, (int)columns.size(), stepColumns);
+    else stepColumns(0, 0, (int)columns.size());
+}
+
+std::size_t ViscosityColumns::bodyCount() const {
+    std::size_t n = 0;
+    for (const CollisionWorld& w : columns) n += w.balls.size();
+    return n;
+}
+
+std::size_t ViscosityColumns::sleepingCount() const {
+    std::size_t n = 0;
+    for (const CollisionWorld& w : columns) n += w.sleep.sleepingCount();
+    return n;
+}
 
-    PhysicsCircle(float x, float y)
-        : shape(10.f), velocity(0.f, 0.f), settled(false)
-    {
-        shape.setOrigin(10.f, 10.f);
-        shape.setPosition(x, y);
-        shape.setFillColor(sf::Color::White);
+float ViscosityColumns::meanFallSpeed(int column) const {
+    const CollisionWorld& w = columns[column];
+    double sum = 0.0;
+    int awake = 0;
+    for (std::size_t i = 0; i < w.balls.size(); ++i) {
+        if (w.sleep.asleep((int)i)) continue;
+        sum += w.balls.vy[i];
+        ++awake;
     }
+    return awake ? (float)(sum / awake) : 0.f;
+}
 
-    float bottom() const { return shape.getPosition().y + shape.getRadius(); }
-    void setBottom(float y) { shape.setPosition(shape.getPosition().x, y - shape.getRadius()); }
-};
+float ViscosityColumns::stokesTerminalSpeed(int column) const {
+    const SceneConfig& config = columns[column].config;
+    return config.drag > 0.f ? config.gravity / config.drag : 0.f;
+}
 
-sf::VertexArray makeWave(const sf::RectangleShape& cont, float phase, sf::Color color) {
+std::size_t ViscosityColumns::memoryBytes() const {
+    std::size_t bytes = capacityBytes(fluids, columns);
+    for (const CollisionWorld& w : columns) bytes += w.memoryBytes();
+    return bytes;
+}
+
+// Fills wave with the triangle strip of a fluid surface
+void makeWave(FrameVector<sf::Vertex>& wave, const sf::RectangleShape& cont, float phase, sf::Color color) {
     const int P = 50;
-    sf::VertexArray wave(sf::TriangleStrip, P * 2);
+    wave.resize(P * 2);
     float dx = cont.getSize().x / (P - 1);
     for (int i = 0; i < P; ++i) {
         float x = i * dx;
@@ -38,111 +168,189 @@ sf::VertexArray makeWave(const sf::RectangleShape& cont, float phase, sf::Color
         wave[i * 2 + 1].position = bot;
         wave[i * 2].color = wave[i * 2 + 1].color = color;
     }
-    return wave;
 }
 
-void runViscositySimulation() {
-    sf::RenderWindow window(sf::VideoMode::getDesktopMode(), "Viscosity Simulation");
-    window.setFramerateLimit(60);
-
-    sf::RectangleShape ground;
-    std::vector<sf::RectangleShape> containers;
-    std::vector<PhysicsCircle> balls;
-    std::vector<sf::Text> labels;
-    std::vector<float> phases;
-    sf::Font font;
-    bool isRunning = false;
-    sf::Clock clock;
-    static constexpr int COUNT = 5;
-    std::vector<float> viscosityValues{ 5.f,8.f,15.f,50.f,30.f };
-    std::vector<std::string> names{ "Water","Alcohol","Oil","Honey","Glycerine" };
-    std::vector<sf::Color> colors{
-        sf::Color(64,164,223,180), sf::Color(194,245,255,180),
-        sf::Color(255,222,89,180), sf::Color(204,142,53,200), sf::Color(230,230,255,200)
-    };
+namespace {
+    class ViscosityScene : public Simulation {
+    public:
+        WindowSettings windowSettings() const override {
+            return { sf::VideoMode::getDesktopMode(), "Viscosity Simulation" };
+        }
 
-    float gh = 350.f;
-    ground.setSize({ (float)window.getSize().x, gh });
-    ground.setPosition(0.f, window.getSize().y - gh);
-    ground.setFillColor(sf::Color::Black);
-
-    if (!font.loadFromFile("OpenSans-Regular.ttf")) std::cerr << "Font load failed\n";
-
-    float width = 150.f, height = 400.f, spacing = 100.f;
-    float startX = (window.getSize().x - (COUNT * width + (COUNT - 1) * spacing)) / 2.f;
-    float topY = window.getSize().y - gh - height;
-
-    for (int i = 0; i < COUNT; ++i) {
-        sf::RectangleShape cont({ width, height });
-        cont.setPosition(startX + i * (width + spacing), topY);
-        cont.setFillColor(sf::Color::Transparent);
-        cont.setOutlineColor(sf::Color::White);
-        cont.setOutlineThickness(2.f);
-        containers.push_back(cont);
-
-        float cx = cont.getPosition().x + width / 2.f;
-        float cy = cont.getPosition().y + height / 2.f - 10.f;
-        balls.emplace_back(cx, cy);
-
-        sf::Text label;
-        label.setFont(font);
-        label.setCharacterSize(20);
-        label.setFillColor(sf::Color::White);
-        float lx = cont.getPosition().x + 10.f;
-        float ly = cont.getPosition().y + height + 5.f;
-        label.setPosition(lx, ly);
-        std::ostringstream ss;
-        ss << names[i] << " - " << viscosityValues[i] << " mPa·s";
-        label.setString(ss.str());
-        labels.push_back(label);
-
-        phases.push_back(0.f);
-    }
+        void start(sf::RenderWindow& window, JobSystem& pool) override {
+            if (!loadFluids("fluids.csv", fluids)) {
+                std::cerr << "fluids.csv not loaded, using the built-in fluids\n";
+                fluids = defaultFluids();
+            }
+            const int count = (int)fluids.size();
+            // M swaps the single balls for a few thousand small ones per column
+            columns.pool = &pool;
 
-    while (window.isOpen()) {
-        float dt = clock.restart().asSeconds();
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) window.close();
-            if (event.type == sf::Event::KeyPressed) {
-                if (event.key.code == sf::Keyboard::Space) isRunning = true;
-                if (event.key.code == sf::Keyboard::R) {
-                    isRunning = false;
-                    for (int i = 0; i < COUNT; ++i) {
-                        float cx = containers[i].getPosition().x + containers[i].getSize().x / 2.f;
-                        float cy = containers[i].getPosition().y + containers[i].getSize().y / 2.f - 10.f;
-                        balls[i].shape.setPosition(cx, cy);
-                        balls[i].velocity = { 0.f,0.f };
-                        balls[i].settled = false;
-                    }
+            float gh = 350.f;
+            ground.setSize({ (float)window.getSize().x, gh });
+            ground.setPosition(0.f, window.getSize().y - gh);
+            ground.setFillColor(sf::Color::Black);
+
+            // Long fluid tables shrink the columns to fit the window
+            float width = 150.f, height = 400.f, spacing = 100.f;
+            const float fit = std::min(1.f, window.getSize().x / (count * (width + spacing)));
+            width *= fit;
+            spacing *= fit;
+            float startX = (window.getSize().x - (count * width + (count - 1) * spacing)) / 2.f;
+            float topY = window.getSize().y - gh - height;
+
+            for (int i = 0; i < count; ++i) {
+                sf::RectangleShape cont({ width, height });
+                cont.setPosition(startX + i * (width + spacing), topY);
+                cont.setFillColor(sf::Color::Transparent);
+                cont.setOutlineColor(sf::Color::White);
+                cont.setOutlineThickness(2.f);
+                containers.push_back(cont);
+
+                float cx = cont.getPosition().x + width / 2.f;
+                float cy = cont.getPosition().y + height / 2.f - 10.f;
+                world.addBall(cx, cy, BALL_RADIUS, fluids[i].viscosity, cont.getPosition().y + height);
+
+                sf::Text label;
+                label.setFont(assets().font("OpenSans-Regular.ttf"));
+                label.setCharacterSize((unsigned)std::max(10.f, 20.f * fit));
+                label.setFillColor(sf::Color::White);
+                float lx = cont.getPosition().x + 10.f;
+                float ly = cont.getPosition().y + height + 5.f;
+                label.setPosition(lx, ly);
+                labels.push_back(label);
+
+                phases.push_back(0.f);
+            }
+            updateLabels();
+
+            for (const sf::RectangleShape& cont : containers)
+                columnRects.push_back(cont.getGlobalBounds());
+            rebuildBatch();
+        }
+
+        void handleEvent(const sf::Event& event, sf::RenderWindow&) override {
+            if (event.type != sf::Event::KeyPressed) return;
+            if (event.key.code == sf::Keyboard::Space) isRunning = true;
+            if (event.key.code == sf::Keyboard::M) {
+                isRunning = false;
+                columnMode = !columnMode;
+                if (columnMode) buildColumns();
+                rebuildBatch();
+                updateLabels();
+            }
+            if (event.key.code == sf::Keyboard::R) {
+                isRunning = false;
+                if (columnMode) buildColumns();
+                for (std::size_t i = 0; i < containers.size(); ++i) {
+                    float cx = containers[i].getPosition().x + containers[i].getSize().x / 2.f;
+                    float cy = containers[i].getPosition().y + containers[i].getSize().y / 2.f - 10.f;
+                    world.resetBall((int)i, cx, cy);
                 }
             }
         }
-        if (isRunning) {
-            for (int i = 0; i < COUNT; ++i) {
-                if (!balls[i].settled) {
-                    float a = PROJECTILE_GRAVITY - viscosityValues[i] * balls[i].velocity.y;
-                    balls[i].velocity.y += a * dt;
-                    balls[i].shape.move(0.f, balls[i].velocity.y * dt);
-                    float bottomY = containers[i].getPosition().y + containers[i].getSize().y - balls[i].shape.getRadius();
-                    if (balls[i].bottom() >= bottomY) {
-                        balls[i].setBottom(bottomY);
-                        balls[i].settled = true;
-                        balls[i].velocity = { 0.f,0.f };
-                    }
+
+        void step(float dt) override {
+            if (!isRunning) return;
+            if (columnMode) {
+                columns.step(dt);
+            }
+            else {
+                world.balls.savePrevious();
+                world.step(dt);
+            }
+        }
+
+        void update(sf::RenderWindow&, const FrameInfo& frame) override {
+            if (isRunning) {
+                for (float& p : phases)
+                    p += frame.seconds * 2.f;
+            }
+            if (columnMode) updateLabels();
+        }
+
+        void render(sf::RenderWindow& window, const FrameInfo& frame) override {
+            const float alpha = frame.alpha;
+            window.draw(ground);
+            const ArenaScope scratch;
+            FrameVector<sf::Vertex> wave;
+            for (std::size_t i = 0; i < containers.size(); ++i) {
+                window.draw(containers[i]);
+                makeWave(wave, containers[i], phases[i], fluids[i].color);
+                window.draw(wave.data(), wave.size(), sf::TriangleStrip);
+                window.draw(labels[i]);
+            }
+            if (columnMode) {
+                std::size_t slot = 0;
+                for (const CollisionWorld& w : columns.columns)
+                    for (std::size_t i = 0; i < w.balls.size(); ++i)
+                        ballBatch.set(slot++, w.balls.renderX(i, alpha), w.balls.renderY(i, alpha), w.balls.radius[i]);
+            }
+            else {
+                const ParticleStore& balls = world.balls;
+                for (std::size_t i = 0; i < balls.size(); ++i)
+                    ballBatch.set(i, balls.renderX(i, alpha), balls.renderY(i, alpha), balls.radius[i]);
+            }
+            ballBatch.upload();
+            window.draw(ballBatch);
+        }
+
+    private:
+        // Column mode adds the measured fall speed against the Stokes estimate g / k
+        void updateLabels() {
+            for (std::size_t i = 0; i < labels.size(); ++i) {
+                std::ostringstream ss;
+                ss << fluids[i].name << " - " << fluids[i].viscosity << " mPa·s";
+                if (columnMode) {
+                    ss.precision(0);
+                    ss << std::fixed << "\nv " << columns.meanFallSpeed((int)i)
+                       << " / " << columns.stokesTerminalSpeed((int)i) << " px/s";
                 }
-                phases[i] += dt * 2.f;
+                labels[i].setString(ss.str());
             }
         }
-        window.clear(sf::Color::Black);
-        window.draw(ground);
-        for (int i = 0; i < COUNT; ++i) {
-            window.draw(containers[i]);
-            window.draw(makeWave(containers[i], phases[i], colors[i]));
-            window.draw(balls[i].shape);
-            window.draw(labels[i]);
+
+        // All balls go out in one batched draw call
+        void rebuildBatch() {
+            ballBatch.clear();
+            if (columnMode) {
+                ballBatch.reserve(columns.bodyCount());
+                for (const CollisionWorld& w : columns.columns)
+                    for (std::size_t i = 0; i < w.balls.size(); ++i)
+                        ballBatch.add(w.balls.x[i], w.balls.y[i], w.balls.radius[i], sf::Color::White);
+            }
+            else {
+                const ParticleStore& balls = world.balls;
+                for (std::size_t i = 0; i < balls.size(); ++i)
+                    ballBatch.add(balls.x[i], balls.y[i], balls.radius[i], sf::Color::White);
+            }
         }
-        window.display();
-    }
+
+        void buildColumns() {
+            // The outline is part of the global bounds; keep the balls inside it
+            std::vector<sf::FloatRect> inner = columnRects;
+            for (sf::FloatRect& r : inner) {
+                r.left += 2.f; r.top += 2.f;
+                r.width -= 4.f; r.height -= 4.f;
+            }
+            columns.build(fluids, inner, COLUMN_BALLS, COLUMN_BALL_RADIUS, 1u);
+        }
+
+        std::vector<Fluid> fluids;
+        ViscosityWorld world;
+        ViscosityColumns columns;
+        bool isRunning = false, columnMode = false;
+
+        sf::RectangleShape ground;
+        std::vector<sf::RectangleShape> containers;
+        std::vector<sf::FloatRect> columnRects;
+        std::vector<sf::Text> labels;
+        std::vector<float> phases;
+        CircleBatch ballBatch;
+    };
+}
+
+void runViscositySimulation() {
+    ViscosityScene scene;
+    runSimulation(scene);
 }
-       
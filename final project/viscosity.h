@@ -0,0 +1,66 @@
+#pragma once
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "kollision.h"
+#include "particleStore.h"
+#include "sleep.h"
+
+class JobSystem;
+
+struct Fluid {
+    std::string name;
+    float viscosity; // drag coefficient of a ball falling through it
+    sf::Color color;
+};
+
+// The five fluids of the interactive scene.
+const std::vector<Fluid>& defaultFluids();
+
+// Reads a fluid table, one "name,viscosity,r,g,b[,a]" line per fluid; blank
+// lines and lines starting with # are skipped. Returns false, leaving out
+// empty, when the file cannot be opened or holds no valid line.
+bool loadFluids(const std::string& path, std::vector<Fluid>& out);
+
+// Balls sinking through fluid columns under gravity with linear drag.
+struct ViscosityWorld {
+    ParticleStore balls;
+    SleepSystem sleep;                  // a ball sleeps once it reaches its floor
+    std::vector<float> viscosity;       // drag coefficient per ball
+    std::vector<float> containerBottom; // floor of each ball's column
+
+    int addBall(float x, float y, float radius, float drag, float bottom);
+    void resetBall(int i, float x, float y);
+    void step(float dt);
+    std::size_t memoryBytes() const {
+        return balls.memoryBytes() + sleep.memoryBytes() + capacityBytes(viscosity, containerBottom);
+    }
+};
+
+// Many balls per fluid: every column is its own collision world with gravity
+// and the fluid's drag, so balls settle on each other through the shared
+// broadphase. Columns never interact, so they step in parallel, one column
+// per task; results do not depend on the thread count.
+struct ViscosityColumns {
+    std::vector<Fluid> fluids;
+    std::vector<CollisionWorld> columns; // one per fluid
+    JobSystem* pool = nullptr;          // null steps the columns in turn
+
+    // One column per fluid with the given rectangle, ballsPerColumn balls of
+    // the given radius scattered through it.
+    void build(const std::vector<Fluid>& fluids, const std::vector<sf::FloatRect>& rects,
+        int ballsPerColumn, float radius, unsigned seed);
+    void step(float dt);
+
+    std::size_t bodyCount() const;
+    std::size_t sleepingCount() const;
+    // Mean downward speed of the awake balls of a column, the measured
+    // terminal velocity once the column has fallen for a while.
+    float meanFallSpeed(int column) const;
+    // Terminal velocity of a lone ball under linear drag, g / k.
+    float stokesTerminalSpeed(int column) const;
+    std::size_t memoryBytes() const;
+};
+
+void runViscositySimulation();